@@ -4,98 +4,277 @@
  */
 #pragma once
 
-#include <cstddef>            // for size_t
-#include <string_view>        // for hash
-#include <unordered_set>      // for unordered_set
+#include <algorithm>          // for copy, equal, sort
+#include <atomic>             // for atomic
+#include <cstddef>            // for size_t, nullptr_t
+#include <cstdint>            // for uint32_t, uint64_t
+#include <utility>            // for swap
 #include <vector>             // for vector, operator==, allocator
 #include "globalPrimitives.h" // for vi, standardBitset
 
 /**
- * @brief vector<int> hash, used to hash assembly states
+ * @brief Canonical key of an assembly state: the canonical index of its first fragment followed by the sorted indices
+ * of the others. Keys of up to INLINE_IDS fragments are stored in the key itself, so building one does not allocate.
+ * The 64-bit fingerprint is computed once when the key is built, and compared before the indices
  */
-template <>
-struct std::hash<vi>
+class stateKey
 {
-    size_t operator()(const vi &v) const
+public:
+    static constexpr size_t INLINE_IDS = 14;
+
+    stateKey() { seal(); }
+
+    /**
+     * @brief Key with the indices ids, taken as they are. Keys read back from a checkpoint come as vi
+     */
+    stateKey(const vi &_ids) : stateKey(_ids.data(), _ids.size()) {}
+
+    stateKey(const int *_ids, size_t _n)
+    {
+        std::copy(_ids, _ids + _n, allocate(_n));
+        seal();
+    }
+
+    /**
+     * @brief Key of a state with n fragments, whose canonical indices are read from first and every stride bytes after
+     * it. Only the fingerprint is computed here. The indices are copied and sorted when they are first needed, which
+     * a table only does when a slot has the same fingerprint or the key is inserted, so most keys of states already
+     * in the table are never sorted. The key must not outlive the fragments it reads from
+     *
+     * @param idSum sum of idKey over the indices of all n fragments, kept by the state as its fragments change, so
+     * that the fingerprint takes no pass over the indices
+     */
+    stateKey(size_t _n, const int *first, size_t stride, uint64_t idSum)
+    {
+        n = _n;
+        if (n > 0)
+        {
+            source = reinterpret_cast<const char *>(first);
+            sourceStride = stride;
+        }
+        fp = finish(n == 0 ? idSum : idSum - idKey(*first) + firstIdKey(*first));
+    }
+
+    size_t size() const { return n; }
+    const int *data() const
+    {
+        if (source != nullptr)
+            build();
+        return n <= INLINE_IDS ? ids : spill.data();
+    }
+    int operator[](size_t i) const { return data()[i]; }
+    /// @brief well mixed in both the high and low bits, so it can pick both a shard and a slot
+    uint64_t fingerprint() const { return fp; }
+
+    bool operator==(const stateKey &other) const
+    {
+        return fp == other.fp && n == other.n && std::equal(data(), data() + n, other.data());
+    }
+    bool operator!=(const stateKey &other) const { return !(*this == other); }
+
+    /**
+     * @brief Random key of a canonical index. The fingerprint of a key is a sum of these, which does not depend on
+     * the order of the indices, so a state updates it in O(1) for each fragment it gains or loses. A sum rather than
+     * a xor, as the same fragment often occurs more than once in a state
+     */
+    static uint64_t idKey(int id) { return mix(uint32_t(id)); }
+
+
+private:
+    uint64_t fp = 0;
+    uint32_t n = 0;
+    mutable int ids[INLINE_IDS];
+    /// @brief the indices of keys longer than INLINE_IDS, empty otherwise
+    mutable std::vector<int> spill;
+    /// @brief where the indices of a key that has not been built yet are read from, nullptr once they are stored
+    mutable const char *source = nullptr;
+    size_t sourceStride = 0;
+
+    int *allocate(size_t _n)
     {
-        std::size_t seed = v.size();
-        for (auto &i : v)
+        n = _n;
+        if (n <= INLINE_IDS)
+            return ids;
+        spill.resize(n);
+        return spill.data();
+    }
+
+    /// @brief copy the indices from source and sort all but the first
+    void build() const
+    {
+        int *p = ids;
+        if (n > INLINE_IDS)
         {
-            seed ^= i + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            spill.resize(n);
+            p = spill.data();
         }
-        return seed;
+        for (size_t i = 0; i < n; i++)
+            p[i] = *reinterpret_cast<const int *>(source + i * sourceStride);
+        if (n > 1)
+            std::sort(p + 1, p + n);
+        source = nullptr;
+    }
+
+    /// @brief splitmix64 finaliser
+    static uint64_t mix(uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    /// @brief key of the index of the first fragment, which is not sorted with the others, drawn from other inputs
+    /// than idKey
+    static uint64_t firstIdKey(int id) { return mix(uint64_t(uint32_t(id)) | (uint64_t(1) << 32)); }
+
+    /// @brief mixes in the number of indices, and spreads the sum over both the high (shard) and low (slot) bits
+    uint64_t finish(uint64_t sum) const { return mix(sum ^ (uint64_t(n) << 48)); }
+
+    void seal()
+    {
+        const int *p = data();
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; i++)
+            sum += i == 0 ? firstIdKey(p[i]) : idKey(p[i]);
+        fp = finish(sum);
     }
 };
 
+struct assemblyPath;
+struct pathArena;
+
 /**
- * @brief Struct which is inserted into the hash table to store assembly states and recover the pathway
+ * @brief Take a reference to a node
  */
-struct assemblyPath
-{
-    /// vi represneting canonical indices of the fragments of the assembly state
-    vi key;
-    /// @brief number of duplicated bonds found so far
-    int sumDupBonds;
-    /// @brief needed to reconstruct the pathway
-    unsigned short match, duplicate;
-    /// @brief Assembly state from which this state is generated. needed to reconstruct the pathway
-    assemblyPath *parent;
-};
+void retainPath(assemblyPath *ap);
 
 /**
- * @brief Wrapper for pathway hash table because C++ unordered_map does not guarantee pointer will remain unchanged
- *
+ * @brief Drop a reference to a node, returning it to its arena once none are left
  */
-struct apWrapper
-{
-    assemblyPath *ap;
+void releasePath(assemblyPath *ap);
 
-    bool operator==(const apWrapper &ap2) const
+/**
+ * @brief Counted reference to an assemblyPath. A node lives as long as the pathway hash table, a search state or a
+ * child node refers to it, so nodes evicted from a bounded table stay valid wherever they are still needed
+ */
+class pathPtr
+{
+public:
+    pathPtr() {}
+    pathPtr(std::nullptr_t) {}
+    explicit pathPtr(assemblyPath *_p) : p(_p)
+    {
+        if (p != nullptr)
+            retainPath(p);
+    }
+    pathPtr(const pathPtr &other) : pathPtr(other.p) {}
+    pathPtr(pathPtr &&other) noexcept : p(other.p) { other.p = nullptr; }
+    pathPtr &operator=(pathPtr other) noexcept
     {
-        return ap->key == ap2.ap->key;
+        std::swap(p, other.p);
+        return *this;
     }
+    ~pathPtr()
+    {
+        if (p != nullptr)
+            releasePath(p);
+    }
+
+    assemblyPath *get() const { return p; }
+    assemblyPath *operator->() const { return p; }
+    assemblyPath &operator*() const { return *p; }
+    bool operator==(const pathPtr &other) const { return p == other.p; }
+    bool operator!=(const pathPtr &other) const { return p != other.p; }
+    bool operator==(std::nullptr_t) const { return p == nullptr; }
+    bool operator!=(std::nullptr_t) const { return p != nullptr; }
+    void reset() { *this = pathPtr(); }
+
+private:
+    assemblyPath *p = nullptr;
 };
 
-/// Pointer for the minimum assembly path
-extern assemblyPath *minAssemblyPath;
+/**
+ * @brief Struct which is inserted into the hash table to store assembly states and recover the pathway.
+ * Nodes are created in a pathArena, with the key stored right after the node
+ */
+struct assemblyPath
+{
+    /// canonical indices of the fragments of the assembly state
+    int *key;
+    /// @brief number of entries in key
+    unsigned short keySize;
+    /// @brief needed to reconstruct the pathway
+    unsigned short match, duplicate;
+    /// @brief number of duplicated bonds found so far
+    int sumDupBonds;
+    /// @brief number of pathPtr and hash table slots referring to the node
+    std::atomic<int> refs{0};
+    /// @brief arena the node was created in
+    pathArena *arena;
+    /// @brief Assembly state from which this state is generated. needed to reconstruct the pathway
+    pathPtr parent;
+
+    /**
+     * @brief Whether the node has the given key
+     */
+    bool hasKey(const stateKey &_key) const;
+};
 
-/// Hash table for assembly states for pathway algorithm
-extern std::unordered_set<apWrapper> pathAssemblyMap;
+/// Pointer for the minimum assembly path. Holding it pins the parent chain of the incumbent pathway
+extern pathPtr minAssemblyPath;
 
 /**
- * @brief vi hash called by apWrapper
- *
+ * @brief Bond count and canonical index of a fragment, cached when the fragment is created so that the bounds and
+ * the state hash do not recount or look them up on every visit
  */
-template <>
-struct std::hash<apWrapper>
+struct fragmentInfo
 {
-    size_t operator()(const apWrapper &ap) const
-    {
-        std::size_t seed = ap.ap->key.size();
-        for (auto &i : ap.ap->key)
-        {
-            seed ^= i + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        }
-        return seed;
-    }
+    /// @brief number of bonds in the fragment
+    int size;
+    /// @brief canonical index of the fragment, -1 if it has not been canonised
+    int canon;
 };
 
 /**
  * @brief Assembly state data structure. Records the current state of this assembly pathway
  */
+template <size_t W>
 struct assemblyState
 {
     /// @brief each mask represents a separate fragment as a boolean edge list
-    std::vector<standardBitset> masks;
+    std::vector<standardBitset<W>> masks;
+    /// @brief the descriptor of each fragment of masks. Kept as a separate vector, since the enumeration and the
+    /// mask kernels work on masks as a contiguous vector
+    std::vector<fragmentInfo> frags;
+    /// @brief sum of stateKey::idKey over the canonical indices in frags, updated with every fragment gained or lost
+    uint64_t idSum = 0;
     /// @brief number of duplicated bonds
     int sumDupBonds = 0;
     /// @brief index of the state
     int ix = 0;
     /// @brief path that was used to generate this state
-    assemblyPath *apPtr = nullptr;
+    pathPtr apPtr;
+
+    /**
+     * @brief Appends a fragment with its descriptor
+     *
+     * @param canon canonical index of the fragment, -1 if it has not been canonised
+     */
+    void addFragment(const standardBitset<W> &mask, int canon)
+    {
+        masks.push_back(mask);
+        frags.push_back({int(mask.count()), canon});
+        idSum += stateKey::idKey(canon);
+    }
+
+    /**
+     * @brief Fills frags from masks, for states whose masks were set without their descriptors
+     */
+    void describeFragments();
 
     /**
-     * @brief Return the maximum fragment size, by counting the number of set bits in the first mask
+     * @brief Return the maximum fragment size, the number of bonds in the first mask
      *
      * @return int (maximum size of a fragment)
      */
@@ -124,7 +303,7 @@ struct assemblyState
      *
      * @param targetMasks The vector of bitsets used in place of sizeList
      */
-    int maxDupBonds(vi &sizeListMain, int maxFragSize, std::vector<standardBitset> &targetMasks);
+    int maxDupBonds(vi &sizeListMain, int maxFragSize, std::vector<standardBitset<W>> &targetMasks);
 
     /**
      * @brief Like the function above but finds the maximum duplicate bonds for a vector of vector of bitsets
@@ -132,7 +311,7 @@ struct assemblyState
      * @param fragSizeList The result vector
      * @param targetMasks The vector of vector of bitsets
      */
-    void maxDupBonds(vi &fragSizeList, int maxFragSize, std::vector<std::vector<standardBitset>> &targetMasks);
+    void maxDupBonds(vi &fragSizeList, int maxFragSize, std::vector<std::vector<standardBitset<W>>> &targetMasks);
 
     /**
      * @brief The simple branch and bound from v4
@@ -166,11 +345,12 @@ struct assemblyState
     int AI();
 
     /**
-     * @brief Calculates the hash for the assembly state by returning a vi which is subjected to the vi hash
+     * @brief Calculates the key of the assembly state, from the cached canonical indices of its fragments. The key
+     * reads the indices from frags when it is first compared or stored, so the state must not change before then
      *
-     * @return vi The vector<int> to be hashed
+     * @return stateKey The key used by the pathway hash tables
      */
-    vi assemblyHashCalculator();
+    stateKey assemblyHashCalculator();
 
     /**
      * @brief Prints the assembly state
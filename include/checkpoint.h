@@ -0,0 +1,46 @@
+/**
+ * @file checkpoint.h
+ * @brief Writing and reading checkpoints of the serial depth-first search, so that a long search can be resumed
+ * in a new process
+ */
+#pragma once
+#include <atomic>         // for atomic
+#include <cstddef>        // for size_t
+#include <string>         // for string
+#include <vector>         // for vector
+#include "searchEngine.h" // for searchFrame
+
+template <size_t W>
+struct searchTask;
+
+/**
+ * @brief Write the search to file. The checkpoint holds the incumbent and its pathway, the canonisation tables,
+ * both pathway hash tables, the first-level states not yet finished and the stack of the one being searched.
+ * It is written to file.tmp and renamed over file, so an interrupted write leaves the previous checkpoint intact
+ *
+ * @param file Name of the checkpoint file
+ * @param roots The first-level states
+ * @param current Index of the first-level state being searched, earlier ones are complete
+ * @param stack Frames of the search of roots[current]
+ * @param AI The global minimum assembly index found
+ * @return true if the checkpoint was written
+ */
+template <size_t W>
+bool writeCheckpoint(const std::string &file, std::vector<searchTask<W>> &roots, size_t current,
+                     std::vector<searchFrame<W>> &stack, std::atomic<int> &AI);
+
+/**
+ * @brief Restore a checkpoint written by writeCheckpoint for the same molecule. Must be called after the target
+ * molecule has been preprocessed and before any canonisation, since it fills bitsetHashTable, graphHashMap,
+ * pathAssemblyMap and diveMap
+ *
+ * @param file Name of the checkpoint file
+ * @param roots Receives the first-level states still to be searched
+ * @param stack Receives the frames of the search of roots[0]
+ * @param AI Set to the incumbent of the checkpoint
+ * @return true if the checkpoint was restored, false if it could not be read or belongs to another molecule or
+ * mask width
+ */
+template <size_t W>
+bool readCheckpoint(const std::string &file, std::vector<searchTask<W>> &roots, std::vector<searchFrame<W>> &stack,
+                    std::atomic<int> &AI);
@@ -4,62 +4,61 @@
  */
 #pragma once
 #include <stddef.h>           // for size_t
-#include <bitset>             // for bitset, hash
+#include <cstdint>            // for uint32_t
 #include <unordered_map>      // for unordered_map
 #include <utility>            // for pair
 #include <vector>             // for vector
-#include "globalPrimitives.h" // for standardBitset, univEdgeList, vi
+#include "globalPrimitives.h" // for standardBitset, univEdgeList, vi, maskId
+#include "maskPool.h"         // for fragmentPool
 
 /**
- * @brief The nodes of the DAG
- *
+ * @brief One level of the DAG, the duplicatable subgraphs with the same number of bonds, stored as compressed
+ * sparse rows: the columns of the nodes are separate contiguous arrays, and the children of all nodes are one
+ * array, so enumerating the children of a node is a linear scan
  */
-struct dagNode
+struct dagLevel
 {
-    /// @brief the bitset of the node
-    standardBitset mask;
-    /// @brief the canonical form of the node
-    int ix;
-    /// the size + 1 bitsets generated by the bitset of the node
-    vi children;
-
-    dagNode() {}
+    /// @brief the children of node k are children[offsets[k]] to children[offsets[k + 1] - 1]. One entry more
+    /// than there are nodes
+    std::vector<uint32_t> offsets{0};
+    /// @brief indices in the next level of the size + 1 bond subgraphs generated by each node
+    std::vector<uint32_t> children;
+    /// @brief the ID of the bitset of each node in fragmentPool
+    std::vector<maskId> ids;
+    /// @brief the canonical index of each node
+    vi ix;
 
-    dagNode(const standardBitset &_mask, int _ix, std::vector<standardBitset> &_children,
-            std::unordered_map<standardBitset, int> &bitsetToIndex) : mask(_mask), ix(_ix)
-    {
-        children.resize(_children.size());
-        for (size_t i = 0; i < children.size(); i++)
-        {
-            children[i] = bitsetToIndex[_children[i]];
-        }
-    }
+    size_t size() const { return ids.size(); }
 };
 
 /**
- * @brief Comparator struct used to sort the nodes of the DAG
+ * @brief Comparator used to sort masks by their highest differing bit
  *
  */
-struct CompareDagNode
+template <size_t W>
+struct CompareDagMask
 {
-    bool operator()(const dagNode &a, const dagNode &b) const
+    bool operator()(maskId a, maskId b) const
     {
+        const standardBitset<W> &maskA = fragmentPool<W>[a], &maskB = fragmentPool<W>[b];
         // Compare from most significant bit down to 0.
         for (int i = univEdgeList.size(); i >= 0; i--)
         {
-            if (a.mask[i] ^ b.mask[i])
-                return b.mask[i];
+            if (maskA[i] ^ maskB[i])
+                return maskB[i];
         }
         return 0;
     }
 };
 
 /// DAG used to enumerate duplicatable subgraphs
-extern std::vector<std::vector<dagNode>> DAG;
+template <size_t W>
+inline std::vector<dagLevel> DAG;
 
 /**
  * @brief Converts the tempDAG generated by initialRecursiveEnumeration into the more efficient DAG
  * used on all subsequent passes of the algorithm
  *
  */
-void convertDag(std::vector<std::unordered_map<standardBitset, std::pair<int, std::vector<standardBitset>>>> &tempDag);
+template <size_t W>
+void convertDag(std::vector<std::unordered_map<maskId, std::pair<int, std::vector<maskId>>>> &tempDag);
@@ -5,39 +5,48 @@
 #pragma once
 #include <stddef.h>           // for size_t
 #include <bitset>             // for bitset, operator&
+#include <cstdint>            // for uint64_t
 #include <map>                // for map
 #include <unordered_map>      // for unordered_map
 #include <unordered_set>      // for unordered_set
 #include <utility>            // for pair
 #include <vector>             // for vector
 #include "globalPrimitives.h" // for standardBitset, vb
+#include "maskKernels.h"      // for isDisjoint, orInto
+#include "maskPool.h"         // for fragmentPool
 
 /**
  * @brief Struct for storing a potential duplicate
  */
+template <size_t W>
 struct potentialDuplicate
 {
-    /// @brief mask representing edge list of potential duplicate
-    standardBitset mask;
+    /// @brief ID in fragmentPool of the mask representing edge list of potential duplicate
+    maskId id;
     /// @brief the index from the canonise function and index of the fragment
     int idx, fragment;
     potentialDuplicate() {}
 
-    potentialDuplicate(standardBitset &_mask, int _fragment, int _idx) : mask(_mask), fragment(_fragment), idx(_idx) {}
+    potentialDuplicate(maskId _id, int _fragment, int _idx) : id(_id), fragment(_fragment), idx(_idx) {}
 };
 
 /**
  * @brief Struct for storing a potential duplicate during the initial enumeration before the construction of the DAG
  *
  */
-struct initialPotentialDuplicate : potentialDuplicate
+template <size_t W>
+struct initialPotentialDuplicate : potentialDuplicate<W>
 {
+    using potentialDuplicate<W>::id;
+    using potentialDuplicate<W>::fragment;
     /// mask representing presence of specific atoms in the potential duplicate
-    standardBitset atomMask = 0;
+    standardBitset<W> atomMask = 0;
     /// mask representing the edge list of the parent fragment
-    standardBitset fragMask = 0;
+    standardBitset<W> fragMask = 0;
     /// Is the potential duplicate cyclic?
     bool isCyclic = 0;
+    /// fragmentSignature of the mask, which each extension updates for the bond it adds
+    uint64_t signature = 0;
 
     /**
      * @brief Construct a new potential Duplicate object
@@ -46,45 +55,46 @@ struct initialPotentialDuplicate : potentialDuplicate
      * @param _fragMask Boolean edgelist of the fragment the duplicate is part of
      * @param _fragment Index of the fragment in its assembly state
      */
-    initialPotentialDuplicate(int x, standardBitset &_fragMask, size_t _fragment);
+    initialPotentialDuplicate(int x, standardBitset<W> &_fragMask, size_t _fragment);
 
     /**
      * @brief TODO: document
      */
-    void generate(std::vector<initialPotentialDuplicate> &q, size_t fragment, std::unordered_set<standardBitset> &maskMap);
+    void generate(std::vector<initialPotentialDuplicate> &q, size_t fragment, std::unordered_set<maskId> &maskMap);
 
     /**
      * @brief Generate potential matches originating from this fragment and update the DAG
      *
-     * @param q Potential duplicates which are isomorphic to this.mask
+     * @param q Potential duplicates which are isomorphic to this one
      * @param fragment Index of the fragment in its assembly state
-     * @param maskMap Hash table of boolean edgelists of all fragments taken before to avoid repetition
+     * @param maskMap IDs of the boolean edgelists of all fragments taken before to avoid repetition
      */
-    void generateDAG(std::vector<initialPotentialDuplicate> &q, size_t fragment, std::unordered_set<standardBitset> &maskMap,
-                     std::vector<std::unordered_map<standardBitset, std::pair<int, std::vector<standardBitset>>>> &tempDag);
+    void generateDAG(std::vector<initialPotentialDuplicate> &q, size_t fragment, std::unordered_set<maskId> &maskMap,
+                     std::vector<std::unordered_map<maskId, std::pair<int, std::vector<maskId>>>> &tempDag);
 };
 
 /**
  * @brief Struct containing pair of valid duplicates for subsequent fragmentation
  *
  */
+template <size_t W>
 struct validMatchings
 {
-    /// @brief first and second duplicate masks
-    standardBitset first, second;
+    /// @brief IDs in fragmentPool of the first and second duplicate masks
+    maskId first, second;
     /// @brief frag 1 and frag 2 are indices of first, second respectively. maskFragSize is the maximum size of these fragments
     int frag1, frag2, maxFragSize;
     validMatchings() {}
-    validMatchings(standardBitset &_first, standardBitset &_second, int _frag1, int _frag2, int _maxFragSize) : first(_first), second(_second), frag1(_frag1), frag2(_frag2), maxFragSize(_maxFragSize) {}
+    validMatchings(maskId _first, maskId _second, int _frag1, int _frag2, int _maxFragSize) : first(_first), second(_second), frag1(_frag1), frag2(_frag2), maxFragSize(_maxFragSize) {}
 };
 
-template <typename potentialDuplicate>
+template <size_t W, typename potentialDuplicate>
 struct duplicateSet
 {
     /// @brief bitset count of the duplicates in the duplicate set
     size_t size;
     /// @brief fragment masks from the assembly states
-    std::vector<standardBitset> maskList;
+    std::vector<standardBitset<W>> maskList;
     /// @brief list of potential duplicates
     std::vector<potentialDuplicate> list;
     duplicateSet() {}
@@ -100,7 +110,7 @@ struct duplicateSet
     void insert(const potentialDuplicate &m)
     {
         list.push_back(m);
-        maskList[m.fragment] |= m.mask;
+        orInto(maskList[m.fragment], fragmentPool<W>[m.id]);
     }
 
     /**
@@ -114,7 +124,7 @@ struct duplicateSet
         int count = 0, last = 0;
         for (size_t i = 0; i < maskList.size(); i++)
         {
-            if (maskList[i] != 0)
+            if (maskList[i].any())
             {
                 count++;
                 last = i;
@@ -134,7 +144,7 @@ struct duplicateSet
      * @return true if any valid matchings exist
      * @return false otherwise
      */
-    bool generateMatchings(std::vector<validMatchings> &v)
+    bool generateMatchings(std::vector<validMatchings<W>> &v)
     {
         bool output = 0;
         for (size_t i = 0; i < list.size(); i++)
@@ -146,15 +156,15 @@ struct duplicateSet
                 {
                     if (frag == list[j].fragment)
                     {
-                        if ((list[i].mask & list[j].mask) == 0)
+                        if (isDisjoint(fragmentPool<W>[list[i].id], fragmentPool<W>[list[j].id]))
                         {
-                            validMatchings p(list[i].mask, list[j].mask, frag, frag, size);
+                            validMatchings<W> p(list[i].id, list[j].id, frag, frag, size);
                             v.push_back(p);
                         }
                     }
                     else
                     {
-                        validMatchings p(list[i].mask, list[j].mask,
+                        validMatchings<W> p(list[i].id, list[j].id,
                                          list[i].fragment, list[j].fragment, size);
                         v.push_back(p);
                     }
@@ -169,9 +179,12 @@ struct duplicateSet
  * @brief Set of boolean edgelists which are isomorphic
  *
  */
-struct initialDuplicateSet : duplicateSet<initialPotentialDuplicate>
+template <size_t W>
+struct initialDuplicateSet : duplicateSet<W, initialPotentialDuplicate<W>>
 {
-    using duplicateSet::duplicateSet;
+    using duplicateSet<W, initialPotentialDuplicate<W>>::duplicateSet;
+    using duplicateSet<W, initialPotentialDuplicate<W>>::size;
+    using duplicateSet<W, initialPotentialDuplicate<W>>::list;
     /**
      * @brief Generate size + 1 matchings from the current set and populate the DAG during the initial enumeration
      *
@@ -181,9 +194,9 @@ struct initialDuplicateSet : duplicateSet<initialPotentialDuplicate>
      * @return true if any valid matchings exist
      * @return false otherwise
      */
-    bool dagPopulator(std::vector<initialPotentialDuplicate> &q,
-                      std::unordered_set<standardBitset> &maskMap,
-                      std::vector<std::unordered_map<standardBitset, std::pair<int, std::vector<standardBitset>>>> &tempDag)
+    bool dagPopulator(std::vector<initialPotentialDuplicate<W>> &q,
+                      std::unordered_set<maskId> &maskMap,
+                      std::vector<std::unordered_map<maskId, std::pair<int, std::vector<maskId>>>> &tempDag)
     {
         bool output = 0;
         vb alive(list.size(), 0);
@@ -196,7 +209,7 @@ struct initialDuplicateSet : duplicateSet<initialPotentialDuplicate>
                 {
                     if (frag == list[j].fragment)
                     {
-                        if ((list[i].mask & list[j].mask) == 0)
+                        if (isDisjoint(fragmentPool<W>[list[i].id], fragmentPool<W>[list[j].id]))
                         {
                             alive[i] = 1;
                             alive[j] = 1;
@@ -224,10 +237,11 @@ struct initialDuplicateSet : duplicateSet<initialPotentialDuplicate>
 /**
  * @brief Version of initialDuplicateSet which uses the DAG to search the duplicatable subgraph space more quickly
  */
-struct dagDuplicateSet : duplicateSet<potentialDuplicate>
+template <size_t W>
+struct dagDuplicateSet : duplicateSet<W, potentialDuplicate<W>>
 {
     bool dead = 1;
-    using duplicateSet::duplicateSet;
+    using duplicateSet<W, potentialDuplicate<W>>::duplicateSet;
 };
 
 /**
@@ -242,7 +256,8 @@ struct dagDuplicateSet : duplicateSet<potentialDuplicate>
  * @return true if the canonical index of any duplicate is greater than the ordinal
  * @return false otherwise
  */
-bool dagGenerate(potentialDuplicate &d, std::map<int, dagDuplicateSet> &stmap, standardBitset &fragment,
+template <size_t W>
+bool dagGenerate(potentialDuplicate<W> &d, std::map<int, dagDuplicateSet<W>> &stmap, standardBitset<W> &fragment,
                  size_t size, int ordinal, size_t frags);
 
 /**
@@ -258,5 +273,6 @@ bool dagGenerate(potentialDuplicate &d, std::map<int, dagDuplicateSet> &stmap, s
  * @return true if any valid duplicatable subgraphs found and not the final iteration
  * @return false
  */
-bool dagDuplicateGenerator(dagDuplicateSet &ds, std::map<int, dagDuplicateSet> &stmap,
-                           std::vector<standardBitset> &takenMasks, std::vector<standardBitset> &stateMasks, int ordinal, bool &overweight, bool last);
\ No newline at end of file
+template <size_t W>
+bool dagDuplicateGenerator(dagDuplicateSet<W> &ds, std::map<int, dagDuplicateSet<W>> &stmap,
+                           std::vector<standardBitset<W>> &takenMasks, std::vector<standardBitset<W>> &stateMasks, int ordinal, bool &overweight, bool last);
\ No newline at end of file
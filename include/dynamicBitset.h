@@ -0,0 +1,163 @@
+/**
+ * @file dynamicBitset.h
+ * @brief Bitset sized at run time, for molecules too large for the fixed mask widths
+ */
+#pragma once
+#include <bitset>     // for bitset
+#include <cstddef>    // for size_t
+#include <cstdint>    // for uint64_t
+#include <functional> // for hash
+#include <ostream>    // for ostream
+#include <vector>     // for vector
+
+/**
+ * @brief Drop-in replacement for std::bitset whose width is set at run time. Every mask of a search has the same
+ * width, so it is a static member set once per molecule with setWidth, and default-constructed masks already
+ * have it. Operations work a 64-bit word at a time
+ */
+struct dynamicBitset
+{
+    /// @brief number of 64-bit words of every mask
+    static inline size_t wordCount = 1;
+
+    /**
+     * @brief Set the width of all masks constructed from now on to at least bits
+     */
+    static void setWidth(size_t bits) { wordCount = bits == 0 ? 1 : (bits + 63) / 64; }
+
+    std::vector<uint64_t> words;
+
+    dynamicBitset() : words(wordCount, 0) {}
+    dynamicBitset(unsigned long long x) : words(wordCount, 0) { words[0] = x; }
+
+    /**
+     * @brief Proxy for a single bit, as returned by std::bitset::operator[]
+     */
+    struct reference
+    {
+        uint64_t &word;
+        uint64_t bit;
+
+        reference(uint64_t &_word, size_t i) : word(_word), bit(uint64_t(1) << (i & 63)) {}
+        reference &operator=(bool x)
+        {
+            if (x)
+                word |= bit;
+            else
+                word &= ~bit;
+            return *this;
+        }
+        reference &operator=(const reference &r) { return *this = bool(r); }
+        operator bool() const { return word & bit; }
+        bool operator~() const { return !(word & bit); }
+    };
+
+    bool operator[](size_t i) const { return test(i); }
+    reference operator[](size_t i) { return reference(words[i >> 6], i); }
+    bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+
+    dynamicBitset &set()
+    {
+        for (size_t i = 0; i < words.size(); i++)
+            words[i] = ~uint64_t(0);
+        return *this;
+    }
+    dynamicBitset &set(size_t i, bool x = true)
+    {
+        (*this)[i] = x;
+        return *this;
+    }
+    dynamicBitset &reset()
+    {
+        for (size_t i = 0; i < words.size(); i++)
+            words[i] = 0;
+        return *this;
+    }
+    dynamicBitset &reset(size_t i)
+    {
+        words[i >> 6] &= ~(uint64_t(1) << (i & 63));
+        return *this;
+    }
+    dynamicBitset &flip(size_t i)
+    {
+        words[i >> 6] ^= uint64_t(1) << (i & 63);
+        return *this;
+    }
+
+    size_t size() const { return words.size() * 64; }
+    size_t count() const
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < words.size(); i++)
+            n += std::bitset<64>(words[i]).count();
+        return n;
+    }
+    bool any() const
+    {
+        for (size_t i = 0; i < words.size(); i++)
+            if (words[i])
+                return true;
+        return false;
+    }
+    bool none() const { return !any(); }
+
+    dynamicBitset &operator&=(const dynamicBitset &b)
+    {
+        for (size_t i = 0; i < words.size(); i++)
+            words[i] &= b.words[i];
+        return *this;
+    }
+    dynamicBitset &operator|=(const dynamicBitset &b)
+    {
+        for (size_t i = 0; i < words.size(); i++)
+            words[i] |= b.words[i];
+        return *this;
+    }
+    dynamicBitset &operator^=(const dynamicBitset &b)
+    {
+        for (size_t i = 0; i < words.size(); i++)
+            words[i] ^= b.words[i];
+        return *this;
+    }
+    dynamicBitset operator~() const
+    {
+        dynamicBitset r(*this);
+        for (size_t i = 0; i < r.words.size(); i++)
+            r.words[i] = ~r.words[i];
+        return r;
+    }
+    bool operator==(const dynamicBitset &b) const { return words == b.words; }
+    bool operator!=(const dynamicBitset &b) const { return words != b.words; }
+};
+
+inline dynamicBitset operator&(dynamicBitset a, const dynamicBitset &b) { return a &= b; }
+inline dynamicBitset operator|(dynamicBitset a, const dynamicBitset &b) { return a |= b; }
+inline dynamicBitset operator^(dynamicBitset a, const dynamicBitset &b) { return a ^= b; }
+
+/**
+ * @brief Writes the bits most significant first, as for std::bitset
+ */
+inline std::ostream &operator<<(std::ostream &os, const dynamicBitset &b)
+{
+    for (size_t i = b.size(); i-- > 0;)
+        os << (b.test(i) ? '1' : '0');
+    return os;
+}
+
+/**
+ * @brief Hash for unordered_maps keyed by masks
+ */
+template <>
+struct std::hash<dynamicBitset>
+{
+    size_t operator()(const dynamicBitset &b) const
+    {
+        uint64_t h = 0;
+        for (size_t i = 0; i < b.words.size(); i++)
+        {
+            h = (h ^ b.words[i]) * 0x9E3779B97F4A7C15ULL;
+            h ^= h >> 32;
+        }
+        return h;
+    }
+};
@@ -3,7 +3,10 @@
  * @brief code relating to splitting the assembly state into fragments
  */
 #pragma once
+#include <cstddef> // for size_t
+template <size_t W>
 struct assemblyState;
+template <size_t W>
 struct validMatchings;
 
 /**
@@ -13,11 +16,12 @@ struct validMatchings;
  * @param validMatchings The matching with the duplicate pair. matching.first is retained and matching.second is deleted
  * @param _result The resulting assembly state
  */
-void fragmentAssemblyState(assemblyState &_target, validMatchings &matching,
-                           assemblyState &_result);
+template <size_t W>
+void fragmentAssemblyState(assemblyState<W> &_target, validMatchings<W> &matching,
+                           assemblyState<W> &_result);
 
 /**
- * @brief Empty the hash table
+ * @brief Empty the hash tables and release all of their nodes, along with the incumbent pathway
  *
  */
 void clearPathMap();
\ No newline at end of file
@@ -5,21 +5,80 @@
 
 #pragma once
 
-#include <ctime>         // for clock_t
-#include <bitset>        // for bitset
-#include <string>        // for string
-#include <unordered_map> // for unordered_map
-#include <utility>       // for pair
-#include <vector>        // for vector
+#include <atomic>          // for atomic
+#include <cstddef>         // for size_t
+#include <cstdint>         // for uint16_t, uint32_t
+#include <ctime>           // for clock_t
+#include <bitset>          // for bitset
+#include <string>          // for string
+#include <type_traits>     // for integral_constant
+#include <utility>         // for pair
+#include <vector>          // for vector
+#include "dynamicBitset.h" // for dynamicBitset
 
 typedef std::vector<int> vi;
 typedef std::vector<bool> vb;
 typedef std::pair<int, int> pii;
 
+/// Widest fixed mask the search is compiled for
 constexpr int BITSET_LENGTH = 512;
+/// Width used for molecules too large for the fixed widths, whose masks are dynamicBitsets sized at run time
+constexpr size_t DYNAMIC_WIDTH = 0;
 constexpr int MAX_INT = 2147483647;
-constexpr int HASH_DEPTH_MAX = 7;
-using standardBitset = std::bitset<BITSET_LENGTH>;
+/// Mask type of width W, std::bitset for the fixed widths and dynamicBitset for DYNAMIC_WIDTH
+template <size_t W>
+struct maskOf
+{
+    typedef std::bitset<W> type;
+};
+template <>
+struct maskOf<DYNAMIC_WIDTH>
+{
+    typedef dynamicBitset type;
+};
+
+/// Boolean edge list of a fragment. The search is compiled for several widths W, and each molecule is searched with
+/// the narrowest that holds its bonds, so that small molecules do not pay for 512-bit masks
+template <size_t W>
+using standardBitset = typename maskOf<W>::type;
+
+/// Calls X with each width the search is compiled for, used to instantiate the templates of the search
+#define FOR_EACH_MASK_WIDTH(X) X(64) X(128) X(256) X(512) X(DYNAMIC_WIDTH)
+
+/**
+ * @brief Narrowest mask width that holds the bonds and atoms of a molecule
+ *
+ * @param bonds Number of bonds, one bit past the last one is also read
+ * @param atoms Number of atoms, which index the atom masks of the enumeration
+ * @return size_t the width, DYNAMIC_WIDTH if no fixed width is wide enough
+ */
+size_t selectMaskWidth(size_t bonds, size_t atoms);
+
+/**
+ * @brief Call f with std::integral_constant<size_t, W>, where W is the compiled width equal to width
+ */
+template <typename F>
+void dispatchMaskWidth(size_t width, F &&f)
+{
+    switch (width)
+    {
+    case 64:
+        f(std::integral_constant<size_t, 64>());
+        break;
+    case 128:
+        f(std::integral_constant<size_t, 128>());
+        break;
+    case 256:
+        f(std::integral_constant<size_t, 256>());
+        break;
+    case DYNAMIC_WIDTH:
+        f(std::integral_constant<size_t, DYNAMIC_WIDTH>());
+        break;
+    default:
+        f(std::integral_constant<size_t, BITSET_LENGTH>());
+        break;
+    }
+}
 
 template <typename T1, typename T2, typename T3>
 struct triple
@@ -33,24 +92,55 @@ struct triple
 
 extern int DISCHARGE_FREQUENCY, ENUM_MAX;
 extern int minAIfound;
-extern int recursiveCount;
-extern int assemblyIx;
+/// Subtracted from the assembly index and its bounds before they are reported, for the joins of disjoint fragments
+extern int aiOffset;
+extern std::atomic<int> recursiveCount;
+extern std::atomic<int> assemblyIx;
+/// Number of threads used by the branch-and-bound search
+extern int numThreads;
+/// Best-first search instead of depth-first, and the frontier size at which it falls back to depth-first
+extern bool bestFirst;
+extern size_t frontierMax;
+/// Search the children of each state in order of their lower bound instead of the order they are generated in
+extern bool branchOrder;
+/// Expansions a first-level subtree may run for before yielding to the next one, 0 to search them one at a time
+extern size_t sliceNodes;
+/// Checkpoint file written by the depth-first search, empty for none, and the checkpoint file to resume from
+extern std::string checkpointFile, resumeFile;
+/// Processor time and number of expansions between checkpoints, 0 to not checkpoint on that criterion
+extern unsigned long long checkpointTime;
+extern size_t checkpointNodes;
+/// Memory limit of the pathway hash table in MB, 0 for no limit
+extern size_t ttMemory;
+/// Beam width of the greedy dive for an initial incumbent, 0 to skip it
+extern size_t diveBeam;
+/// Assembly index threshold of a decision query, negative for an exact search
+extern int threshold;
 
-extern std::unordered_map<std::string, int> atypeHash;
 extern std::vector<double> coords;
 extern std::string moleculeName;
-extern standardBitset allEdges;
-extern volatile bool interruptFlag;
+/// Width of the masks the current molecule is searched with
+extern size_t maskWidth;
+/// Mask with every bond of the target molecule set
+template <size_t W>
+inline standardBitset<W> allEdges;
+/// Set when the search must stop, by a worker or a signal handler, and read by every worker. It is lock-free, so the
+/// signal handler can store to it
+extern std::atomic<bool> interruptFlag;
 extern clock_t startTime;
 extern unsigned long long runTimeMax;
 
 typedef triple<int, int, int> iii;
-typedef triple<short, short, short> edgeL;
+/// Index of an atom or bond in an edge list
+typedef int edgeIndex;
+/// ID of an atom label in atomLabels
+typedef uint16_t labelId;
+typedef triple<edgeIndex, edgeIndex, edgeIndex> edgeL;
 extern unsigned int totalBonds;
 extern std::vector<edgeL> removedEdges;
 extern std::vector<edgeL> originalEdgeList, univEdgeList;
 
-/// Hash table for edgelists for pathway algorithm
-extern std::unordered_map<standardBitset, pii> bitsetHashTable;
+/// ID of a mask interned in fragmentPool
+typedef uint32_t maskId;
 
 extern bool isPathway, removeHydrogens, disjointCompensation;
\ No newline at end of file
@@ -0,0 +1,23 @@
+/**
+ * @file graphCanon.h
+ * @brief exact canonical labelling of small vertex and edge labelled graphs
+ */
+#pragma once
+#include <string> // for string
+struct labelledGraph;
+
+/**
+ * @brief Canonical certificate of a molecular graph, found by individualisation and refinement in the style of
+ * nauty and bliss. The vertices are coloured by atom type and the colouring refined by the colours and bond types
+ * of their neighbours. Where that leaves vertices alike, each one in turn is individualised and refined again,
+ * pruning the branches that automorphisms found so far map onto each other. The certificate is the smallest
+ * encoding of the graph under the labellings reached.
+ *
+ * Two graphs have the same certificate if and only if they are isomorphic with the same atom and bond types, so
+ * comparing certificates replaces an isomorphism test
+ *
+ * @param g Graph to be labelled
+ * @return std::string the certificate, as bytes
+ */
+std::string canonicalCertificate(const labelledGraph &g);
+
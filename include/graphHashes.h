@@ -5,50 +5,39 @@
  */
 
 #pragma once
-#include <algorithm>          // for sort
 #include <cstddef>            // for size_t
+#include <cstdint>            // for uint32_t, uint64_t
+#include <optional>           // for optional
+#include <shared_mutex>       // for shared_mutex
 #include <string>             // for hash, operator==, string, __str_hash_base
 #include <unordered_map>      // for hash, unordered_map
-#include <variant>            // for hash
 #include <vector>             // for vector
-#include "globalPrimitives.h" // for standardBitset, univEdgeList, pii
-#include "molGraph.h"         // for molGraph (ptr only), targetMolecule
-#include "vf2.h"              // for edgelistToBoost, vf2GraphIso, molGraph...
+#include "globalPrimitives.h" // for standardBitset, pii, maskId
 
 /**
  * @brief Hashes a molecular graph
  */
+template <size_t W>
 struct graphHash
 {
     /// graph to hash expressed as a bitset of edges
-    standardBitset mask;
-    /// hashes stored as floats
-    std::vector<float> hashes;
-    /// if the graph is acyclic, the tree hash function is used, and the output stored here
-    std::string treeHash;
+    standardBitset<W> mask;
+    /// if the graph is cyclic, its canonical certificate is stored here
+    std::string certificate;
+    /// if the graph is acyclic, its canonical tree key is stored here
+    uint32_t treeKey = 0;
 
     graphHash() {}
 
     /**
      * @brief Construct a new graph Hash object
      *
-     * @param mg molGraph to be hashed
-     * @param depth Depth of the BFS
-     * @param isCyclic Is the molecule cyclic
-     * @param _mask Boolean edgelist of the molGraph
+     * @param _mask Boolean edgelist of the subgraph of targetMolecule to be hashed
      */
-    graphHash(molGraph &mg, int depth, bool isCyclic, standardBitset &_mask);
+    graphHash(const standardBitset<W> &_mask);
 
     /**
-     * @brief Calculate hash for subgraph unordered_map using BFS approach
-     *
-     * @param mg molGraph to be hashed
-     * @param _depth Depth of the BFS
-     */
-    void calcHash(molGraph &mg, int _depth);
-
-    /**
-     * @brief Check isomorphism between two graphs. Uses tree isomorphism if acyclic, else uses vf2 subgraph isomorphism
+     * @brief Check isomorphism between two graphs by comparing their canonical forms
      *
      * @param g2 other graph to be compared
      * @return true if graphs are isomorphic
@@ -56,53 +45,93 @@ struct graphHash
      */
     bool operator==(const graphHash &g2) const
     {
-        if (treeHash.length() != g2.treeHash.length())
-            return false;
-        if (treeHash.length() == 0)
-        {
-            molGraphBoost g1mg = edgelistToBoost(targetMolecule, univEdgeList, this->mask),
-                          g2mg = edgelistToBoost(targetMolecule, univEdgeList, g2.mask);
-            return vf2GraphIso(g1mg, g2mg);
-        }
-        else
-        {
-            return treeHash == g2.treeHash;
-        }
+        return treeKey == g2.treeKey && certificate == g2.certificate;
     }
 };
 
 /**
  * @brief Hash for subgraph unordered_map
  */
-template <>
-struct std::hash<graphHash>
+template <size_t W>
+struct std::hash<graphHash<W>>
 {
-    size_t operator()(const graphHash &gh) const
+    size_t operator()(const graphHash<W> &gh) const
     {
-        if (gh.treeHash.length() == 0)
-        {
-            std::vector<float> sortedHashes = gh.hashes;
-            sort(sortedHashes.begin(), sortedHashes.end());
-            size_t res = 17;
-            for (size_t i = 0; i < sortedHashes.size(); i++)
-            {
-                int k = int(sortedHashes[i] * 1024);
-                res = res * 31 + std::hash<int>()(k);
-            }
-            return res;
-        }
-        else
-        {
-            std::hash<string> hasher;
-            return hasher(gh.treeHash);
-        }
+        return gh.certificate.empty() ? std::hash<uint32_t>()(gh.treeKey) : std::hash<std::string>()(gh.certificate);
     }
 };
 
 /**
- * @brief TODO: document
+ * @brief An isomorphism class of fragments
+ */
+template <size_t W>
+struct fragmentClass
+{
+    /// @brief ID in fragmentPool of the first mask of the class, the one later masks are matched against
+    maskId representative;
+    /// @brief canonical index of the class and number of masks in it
+    pii value;
+    /// @brief canonical form of the representative, only computed once another class has the same signature
+    std::optional<graphHash<W>> hash;
+
+    fragmentClass(maskId _representative, pii _value) : representative(_representative), value(_value) {}
+};
+
+/**
+ * @brief The isomorphism classes of fragments, by fragment signature. Fragments with different signatures are never
+ * isomorphic, so a mask is only matched against the classes of its own signature, and most signatures have one
+ */
+template <size_t W>
+struct fragmentClassTable
+{
+    std::unordered_map<uint64_t, std::vector<fragmentClass<W>>> buckets;
+    /// @brief number of classes, which is also the canonical index of the next one
+    int classes = 0;
+
+    int size() const { return classes; }
+
+    void clear()
+    {
+        buckets.clear();
+        classes = 0;
+    }
+};
+
+/// Isomorphism classes of the fragments canonised so far
+template <size_t W>
+inline fragmentClassTable<W> graphHashMap;
+
+/// Guards bitsetHashTable, graphHashMap and interning into fragmentPool when the search runs on more than one thread
+extern std::shared_mutex canonMutex;
+
+/**
+ * @brief Sets up the tables fragmentSignature reads for targetMolecule and univEdgeList. Called once per molecule,
+ * before anything is canonised
  */
-extern std::unordered_map<graphHash, pii> graphHashMap;
+void prepareFragmentSignatures();
+
+/**
+ * @brief Invariant of the subgraph made of the bonds set in mask: the sum over its atoms of their colours after two
+ * rounds of colour refinement, which start from the atom types and follow the bond types. Isomorphic subgraphs have
+ * the same signature
+ *
+ * @param mask Boolean edgelist of the subgraph
+ * @return uint64_t signature
+ */
+template <size_t W>
+uint64_t fragmentSignature(const standardBitset<W> &mask);
+
+/**
+ * @brief Signature of mask with one more bond, from the signature of mask. Only the terms of the two atoms of the
+ * bond and of their neighbours change, so this reads the bonds around them and nothing else
+ *
+ * @param signature Signature of mask
+ * @param mask Boolean edgelist without the bond
+ * @param edge Index in univEdgeList of the bond added
+ * @return uint64_t signature of mask with the bond set
+ */
+template <size_t W>
+uint64_t extendSignature(uint64_t signature, const standardBitset<W> &mask, size_t edge);
 
 /**
  * @brief Returns unique hash val for subgraph. See Seet et al. section 4.3 Enumeration
@@ -110,4 +139,34 @@ extern std::unordered_map<graphHash, pii> graphHashMap;
  * @param mask Boolean edgelist to be canonised
  * @return int canonical value
  */
-int canonise(standardBitset &mask);
\ No newline at end of file
+template <size_t W>
+int canonise(standardBitset<W> &mask);
+
+/**
+ * @brief Canonises the mask with ID id in fragmentPool
+ */
+template <size_t W>
+int canonise(maskId id);
+
+/**
+ * @brief Canonises the mask with ID id in fragmentPool, whose fragmentSignature is already known
+ */
+template <size_t W>
+int canonise(maskId id, uint64_t signature);
+
+/**
+ * @brief Looks up a boolean edgelist that has already been canonised, without inserting it
+ *
+ * @param mask Boolean edgelist to look up
+ * @param result Canonical index and index within its isomorphism class, if found
+ * @return true if the edgelist has been canonised before
+ * @return false otherwise
+ */
+template <size_t W>
+bool findCanonical(const standardBitset<W> &mask, pii &result);
+
+/**
+ * @brief Looks up the mask with ID id in fragmentPool, without canonising it
+ */
+template <size_t W>
+bool findCanonical(maskId id, pii &result);
\ No newline at end of file
@@ -3,14 +3,34 @@
  * @brief code relating to improved branch and bound algorithm
  */
 #pragma once
+#include <atomic>             // for atomic
 #include <fstream>            // for ofstream
+#include <functional>         // for function
 #include <map>                // for map
 #include <vector>             // for vector
-#include "globalPrimitives.h" // for standardBitset
+#include "globalPrimitives.h"   // for standardBitset
+#include "transpositionTable.h" // for transpositionTable, pathAssemblyMap
+template <size_t W>
 struct assemblyState;
+template <size_t W>
 struct dagDuplicateSet;
+template <size_t W>
 struct initialDuplicateSet;
 struct molGraph;
+template <size_t W>
+struct validMatchings;
+template <size_t W>
+struct searchTask;
+template <size_t W>
+struct rankedChild;
+template <size_t W>
+struct duplicateSetMasks;
+template <size_t W>
+struct searchFrame;
+
+/// Called with each child state that survives the bound and is new to the pathway hash table, and its lower bound
+template <size_t W>
+using childHandler = std::function<void(assemblyState<W> &, int)>;
 
 // using namespace std;
 
@@ -22,7 +42,8 @@ struct molGraph;
  * @return true if any matchings found
  * @return false if no matchings found
  */
-bool initialRecursiveEnumeration(assemblyState &_target, std::vector<std::map<int, initialDuplicateSet>> &stmapVector, bool &earlyTerminate);
+template <size_t W>
+bool initialRecursiveEnumeration(assemblyState<W> &_target, std::vector<std::map<int, initialDuplicateSet<W>>> &stmapVector, bool &earlyTerminate);
 
 /**
  * @brief Enumerate all subgraphs during subsequent phases of the pathway algorithm using the DAG to speed things up.  See seet et al section 4.3 Duplicate Enumeration
@@ -32,8 +53,9 @@ bool initialRecursiveEnumeration(assemblyState &_target, std::vector<std::map<in
  * @return true if matches found
  * @return false otherwise
  */
-int dagRecursiveEnumeration(assemblyState &_target, std::vector<std::map<int, dagDuplicateSet>> &stmapVector,
-                            std::vector<std::vector<standardBitset>> &targetMasks);
+template <size_t W>
+int dagRecursiveEnumeration(assemblyState<W> &_target, std::vector<std::map<int, dagDuplicateSet<W>>> &stmapVector,
+                            std::vector<std::vector<standardBitset<W>>> &targetMasks);
 
 /**
  * @brief This function returns the minimum possible sum of duplicate bonds that can be found if only fragments equal
@@ -43,18 +65,151 @@ int dagRecursiveEnumeration(assemblyState &_target, std::vector<std::map<int, da
  * @param maxFragMask The bitset of all duplicatable subgraphs with the same bitset count as the matching
  * @return int the sum of duplicate bonds calculated by this cutoff function
  */
-int postFragmentationCutoff(assemblyState &target, standardBitset &matchMask, standardBitset &maxFragMask);
+template <size_t W>
+int postFragmentationCutoff(assemblyState<W> &target, standardBitset<W> &matchMask, standardBitset<W> &maxFragMask);
 
 /**
- * @brief The recursive function that enumerates duplicates and generates assembly states on all but the first pass
- * of the assembly algorithm
+ * @brief Records input as the best pathway found so far if it has a lower assembly index than AI.
+ * Safe to call from several search threads
  *
- * @param input The input assembly state
+ * @param input The assembly state reached
  * @param AI The global minimum assembly index found
+ */
+template <size_t W>
+void updateIncumbent(assemblyState<W> &input, std::atomic<int> &AI);
+
+/**
+ * @brief Marks a subtree as completely searched, printing the proven lower bound on the assembly index if it rose
+ *
+ * @param bound The lower bound the subtree was opened with
+ * @param AI The global minimum assembly index found
+ */
+void closeSearchBound(int bound, std::atomic<int> &AI);
+
+/**
+ * @brief Looks up the child state as in the pathway hash table, inserting it if it is new, or re-parenting
+ * it if it has now been reached with more duplicated bonds. Sets as.apPtr and as.ix when the child is to be searched
+ *
+ * @param input The parent assembly state
+ * @param as The child assembly state, with sumDupBonds already set
+ * @param matching The duplicate pair that generated the child from the parent
+ * @param table The pathway hash table to claim the child in
+ * @return true if the child has to be searched
+ * @return false if it has already been reached with at least as many duplicated bonds
+ */
+template <size_t W>
+bool claimAssemblyState(assemblyState<W> &input, assemblyState<W> &as, validMatchings<W> &matching,
+                        transpositionTable &table = pathAssemblyMap);
+
+/**
+ * @brief Enumerates the duplicates of input and generates its children on all but the first pass of the assembly
+ * algorithm. Children are kept as matchings, bounded by their duplicate set, and are neither fragmented nor claimed
+ * in the pathway hash table
+ *
+ * @param input The input assembly state
+ * @param AI The global minimum assembly index found, shared by all search threads
+ * @param children Receives every child of a duplicate set whose lower bound is below AI, in generation order
+ * @param sets Receives the masks of those duplicate sets, which bound their children after fragmentation
  * @return true if any more duplicatable substructures are found
  * @return false otherwise
  */
-bool dagRecursiveAssembly(assemblyState &input, int &AI);
+template <size_t W>
+bool generateChildren(assemblyState<W> &input, std::atomic<int> &AI, std::vector<rankedChild<W>> &children,
+                      std::vector<duplicateSetMasks<W>> &sets);
+
+/**
+ * @brief Fragments input by the matching of a child generated by generateChildren, and raises the bound of the
+ * child to the lower bound of the fragmented state where that is higher
+ *
+ * @param input The state the child was generated from
+ * @param child The child, whose bound is updated
+ * @param set The masks of the child's duplicate set
+ * @param as Receives the child state
+ * @return int the updated bound of the child
+ */
+template <size_t W>
+int fragmentChild(assemblyState<W> &input, rankedChild<W> &child, duplicateSetMasks<W> &set, assemblyState<W> &as);
+
+/**
+ * @brief Generates the children of input and claims them in table, in order of their bound if branchOrder is set.
+ * What happens to each claimed child is left to searchChild
+ *
+ * @param input The input assembly state
+ * @param AI The global minimum assembly index found, shared by all search threads
+ * @param searchChild Called with every child that has to be searched
+ * @param table The pathway hash table children are claimed in
+ * @return true if any more duplicatable substructures are found
+ * @return false otherwise
+ */
+template <size_t W>
+bool expandAssemblyState(assemblyState<W> &input, std::atomic<int> &AI, const childHandler<W> &searchChild,
+                         transpositionTable &table = pathAssemblyMap);
+
+/**
+ * @brief Searches the subtree of input depth-first to completion with a searchEngine. In parallel mode subtrees
+ * may be handed to searchPool instead of being searched here
+ *
+ * @param input The input assembly state
+ * @param bound Lower bound on the assembly index through input, open in openBounds until the subtree is searched
+ * @param AI The global minimum assembly index found, shared by all search threads
+ * @return true if the subtree was searched completely
+ * @return false if the search was interrupted
+ */
+template <size_t W>
+bool dagRecursiveAssembly(assemblyState<W> &input, int bound, std::atomic<int> &AI);
+
+/**
+ * @brief Searches the subtree of a queued state depth-first, closing its bound in openBounds, or only closes it if
+ * the incumbent has since reached its bound
+ *
+ * @param t The queued state and its lower bound
+ * @param AI The global minimum assembly index found
+ */
+template <size_t W>
+void searchSubtree(searchTask<W> &t, std::atomic<int> &AI);
+
+/**
+ * @brief Best-first search. States are expanded in order of their lower bound, and the search stops as soon as
+ * the smallest bound in the frontier reaches the incumbent. Once the frontier holds frontierMax states, popped
+ * states are searched depth-first instead of being expanded into the frontier
+ *
+ * @param roots The first-level states and their lower bounds
+ * @param AI The global minimum assembly index found
+ */
+template <size_t W>
+void bestFirstAssembly(std::vector<searchTask<W>> &roots, std::atomic<int> &AI);
+
+/**
+ * @brief Searches the first-level subtrees one after another, writing a checkpoint to checkpointFile every
+ * checkpointTime or checkpointNodes expansions if it is set
+ *
+ * @param roots The first-level states and their lower bounds
+ * @param AI The global minimum assembly index found
+ * @param resumeStack Frames of a resumed search of roots[0], empty to start it afresh
+ */
+template <size_t W>
+void depthFirstAssembly(std::vector<searchTask<W>> &roots, std::atomic<int> &AI, std::vector<searchFrame<W>> &resumeStack);
+
+/**
+ * @brief Time-slices the first-level subtrees. Each is searched by its own searchEngine, which runs for sliceNodes
+ * expansions before yielding to the next, round robin until all are complete
+ *
+ * @param roots The first-level states and their lower bounds
+ * @param AI The global minimum assembly index found
+ */
+template <size_t W>
+void slicedAssembly(std::vector<searchTask<W>> &roots, std::atomic<int> &AI);
+
+/**
+ * @brief Greedy beam search for a good initial incumbent. Each level keeps the diveBeam states with the most
+ * duplicated bonds, i.e. those that took the largest duplicates, and expands them until no state has children.
+ * States are claimed in diveMap rather than pathAssemblyMap so that the exact search still visits all of them
+ *
+ * @param roots The first-level states and their lower bounds
+ * @param AI The global minimum assembly index found, lowered by the leaves of the dive
+ */
+template <size_t W>
+void greedyDive(std::vector<searchTask<W>> &roots, std::atomic<int> &AI);
 
 /**
  * @brief
@@ -64,15 +219,42 @@ bool dagRecursiveAssembly(assemblyState &input, int &AI);
  * @param input The input assembly state
  * @param AI The global minimum assembly index found
  * @param ofs the output file. If the subgraph enumeration limit is reached, a warning will be written to this file
+ * @param searchChild Called with every first-level state that has to be searched
  * @return true if any more duplicatable substructures are found
  * @return false otherwise
  */
-bool initialRecursiveAssembly(assemblyState &input, int &AI, std::ofstream &ofs);
+template <size_t W>
+bool initialRecursiveAssembly(assemblyState<W> &input, std::atomic<int> &AI, std::ofstream &ofs, const childHandler<W> &searchChild);
+
+/**
+ * @brief Writes the answer of a decision query started with the threshold flag: yes with the witness pathway if a
+ * pathway at or below the threshold was found, undecided if the search was interrupted first, otherwise no
+ *
+ * @param AI The global minimum assembly index found, threshold + 1 if no pathway was found
+ * @param offset Amount subtracted from AI for disjoint compensation
+ * @param removedEdges Edges removed by preprocessing, needed to write the pathway
+ * @param ofs Output file
+ */
+template <size_t W>
+void decisionVerdict(std::atomic<int> &AI, int offset, std::vector<edgeL> &removedEdges, std::ofstream &ofs);
+
+/**
+ * @brief Searches the preprocessed targetMolecule with masks W bits wide. Writes the assembly index found, the
+ * proven lower bound and the gap between them to ofs
+ *
+ * @param removedEdges Edges removed by preprocessing, needed to write the pathway
+ * @param disjointFragments Number of disjoint fragments of the original molecule
+ * @param ofs The output file
+ */
+template <size_t W>
+void searchMolecule(std::vector<edgeL> &removedEdges, int disjointFragments, std::ofstream &ofs);
 
 /**
- * @brief Function that calls the recursive assembly function
+ * @brief Function that calls the recursive assembly function. Preprocesses mg and searches it with the narrowest
+ * mask width that holds its bonds and atoms. Writes the assembly index found, the proven
+ * lower bound and the gap between them to ofs
  *
  * @param mg The target molGraph
  * @param ofs The output file
  */
-void improvedBnB(molGraph &mg, std::ofstream &ofs);
\ No newline at end of file
+void improvedBnB(molGraph &mg, std::ofstream &ofs);
@@ -36,6 +36,84 @@ void owRemoveHydrogens(std::string &_removeHydrogens);
  */
 void owDisjointCompensate(std::string &_removeHydrogens);
 
+/**
+ * @brief search thread count flag
+ *
+ */
+void owThreads(std::string &_threads);
+
+/**
+ * @brief best-first search flag
+ *
+ */
+void owBestFirst(std::string &_bestFirst);
+
+/**
+ * @brief best-first frontier size limit flag
+ *
+ */
+void owFrontierMax(std::string &_frontierMax);
+
+/**
+ * @brief branch ordering flag
+ *
+ */
+void owBranchOrder(std::string &_branchOrder);
+
+/**
+ * @brief subtree time slice flag
+ *
+ */
+void owSliceNodes(std::string &_sliceNodes);
+
+/**
+ * @brief checkpoint file flag
+ *
+ */
+void owCheckpoint(std::string &_checkpoint);
+
+/**
+ * @brief checkpoint interval flag, in processor time
+ *
+ */
+void owCheckpointTime(std::string &_checkpointTime);
+
+/**
+ * @brief checkpoint interval flag, in state expansions
+ *
+ */
+void owCheckpointNodes(std::string &_checkpointNodes);
+
+/**
+ * @brief resume from checkpoint flag
+ *
+ */
+void owResume(std::string &_resume);
+
+/**
+ * @brief pathway hash table memory limit flag
+ *
+ */
+void owTtMemory(std::string &_ttMemory);
+
+/**
+ * @brief greedy dive beam width flag
+ *
+ */
+void owDiveBeam(std::string &_diveBeam);
+
+/**
+ * @brief decision query threshold flag
+ *
+ */
+void owThreshold(std::string &_threshold);
+
+/**
+ * @brief mask kernel set flag
+ *
+ */
+void owMaskKernels(std::string &_maskKernels);
+
 /// For parsing flags
 extern std::unordered_map<std::string, void (*)(std::string &)> fptrTable;
 
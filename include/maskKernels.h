@@ -0,0 +1,177 @@
+/**
+ * @file maskKernels.h
+ * @brief SIMD kernels for the mask operations of the enumeration and the bound, selected at startup for the CPU
+ */
+#pragma once
+#include <algorithm>       // for min
+#include <bitset>          // for bitset
+#include <cstddef>         // for size_t
+#include <cstdint>         // for uint64_t
+#include <string>          // for string
+#include <vector>          // for vector
+#include "dynamicBitset.h" // for dynamicBitset
+
+/**
+ * @brief One implementation of each mask kernel. All of them work on masks of words 64-bit words
+ */
+struct maskKernelSet
+{
+    /// @brief name used by the maskKernels flag
+    const char *name;
+    /// @brief true if every bit of a is set in b
+    bool (*subset)(const uint64_t *a, const uint64_t *b, size_t words);
+    /// @brief true if a and b have no bit in common
+    bool (*disjoint)(const uint64_t *a, const uint64_t *b, size_t words);
+    /// @brief number of bits set in both a and b
+    size_t (*andCount)(const uint64_t *a, const uint64_t *b, size_t words);
+    /// @brief or the n masks of srcs into dst
+    void (*orReduce)(uint64_t *dst, const uint64_t *const *srcs, size_t n, size_t words);
+};
+
+/// Kernels used by the search, the fastest the CPU supports unless overridden with the maskKernels flag
+extern maskKernelSet maskKernels;
+
+/**
+ * @brief The kernel sets the CPU supports, scalar first and fastest last
+ */
+std::vector<const maskKernelSet *> supportedMaskKernels();
+
+/**
+ * @brief Use the supported kernel set called name for the rest of the run
+ *
+ * @return false if there is no such kernel set or the CPU does not support it
+ */
+bool selectMaskKernels(const std::string &name);
+
+/// Narrowest fixed mask width handled by the kernels. Narrower masks are only a word or two, and std::bitset
+/// handles them inline faster than a call through maskKernels
+constexpr size_t KERNEL_MIN_WIDTH = 256;
+
+/**
+ * @brief The words of a fixed width mask, for the kernels. std::bitset does not expose its storage, so maskWords
+ * relies on libstdc++ and libc++ both storing a bitset as its only member, an array of N / 64 words of 64 bits on the
+ * 64-bit targets we build for, with bit i in bit i % 64 of word i / 64. The size and alignment are checked here at
+ * compile time and the bit order by the maskKernels tests, so a library that lays bitsets out otherwise fails the
+ * build or the tests rather than having the kernels read the wrong bits
+ */
+template <size_t N>
+constexpr bool bitsetIsWordArray = N % 64 == 0 && sizeof(std::bitset<N>) == N / 8 &&
+                                   alignof(std::bitset<N>) >= alignof(uint64_t);
+
+template <size_t N>
+inline const uint64_t *maskWords(const std::bitset<N> &m)
+{
+    static_assert(bitsetIsWordArray<N>, "std::bitset is expected to be a plain array of 64-bit words");
+    return reinterpret_cast<const uint64_t *>(&m);
+}
+
+template <size_t N>
+inline uint64_t *maskWords(std::bitset<N> &m)
+{
+    static_assert(bitsetIsWordArray<N>, "std::bitset is expected to be a plain array of 64-bit words");
+    return reinterpret_cast<uint64_t *>(&m);
+}
+
+/**
+ * @brief true if every bond of a is in b
+ */
+template <size_t N>
+inline bool isSubset(const std::bitset<N> &a, const std::bitset<N> &b)
+{
+    if constexpr (N < KERNEL_MIN_WIDTH)
+        return (a | b) == b;
+    else
+        return maskKernels.subset(maskWords(a), maskWords(b), N / 64);
+}
+
+inline bool isSubset(const dynamicBitset &a, const dynamicBitset &b)
+{
+    return maskKernels.subset(a.words.data(), b.words.data(), a.words.size());
+}
+
+/**
+ * @brief true if a and b have no bond in common
+ */
+template <size_t N>
+inline bool isDisjoint(const std::bitset<N> &a, const std::bitset<N> &b)
+{
+    if constexpr (N < KERNEL_MIN_WIDTH)
+        return (a & b).none();
+    else
+        return maskKernels.disjoint(maskWords(a), maskWords(b), N / 64);
+}
+
+inline bool isDisjoint(const dynamicBitset &a, const dynamicBitset &b)
+{
+    return maskKernels.disjoint(a.words.data(), b.words.data(), a.words.size());
+}
+
+/**
+ * @brief Number of bonds in both a and b
+ */
+template <size_t N>
+inline size_t andCount(const std::bitset<N> &a, const std::bitset<N> &b)
+{
+    if constexpr (N < KERNEL_MIN_WIDTH)
+        return (a & b).count();
+    else
+        return maskKernels.andCount(maskWords(a), maskWords(b), N / 64);
+}
+
+inline size_t andCount(const dynamicBitset &a, const dynamicBitset &b)
+{
+    return maskKernels.andCount(a.words.data(), b.words.data(), a.words.size());
+}
+
+/**
+ * @brief dst |= src
+ */
+template <size_t N>
+inline void orInto(std::bitset<N> &dst, const std::bitset<N> &src)
+{
+    if constexpr (N < KERNEL_MIN_WIDTH)
+        dst |= src;
+    else
+    {
+        const uint64_t *srcs[] = {maskWords(src)};
+        maskKernels.orReduce(maskWords(dst), srcs, 1, N / 64);
+    }
+}
+
+inline void orInto(dynamicBitset &dst, const dynamicBitset &src)
+{
+    const uint64_t *srcs[] = {src.words.data()};
+    maskKernels.orReduce(dst.words.data(), srcs, 1, dst.words.size());
+}
+
+/**
+ * @brief dst |= every mask of srcs
+ */
+template <size_t N>
+inline void orReduce(std::bitset<N> &dst, const std::vector<std::bitset<N>> &srcs)
+{
+    if constexpr (N < KERNEL_MIN_WIDTH)
+    {
+        for (size_t i = 0; i < srcs.size(); i++)
+            dst |= srcs[i];
+    }
+    else
+    {
+        const uint64_t *words[16];
+        for (size_t i = 0; i < srcs.size(); i += 16)
+        {
+            size_t n = std::min(srcs.size() - i, size_t(16));
+            for (size_t j = 0; j < n; j++)
+                words[j] = maskWords(srcs[i + j]);
+            maskKernels.orReduce(maskWords(dst), words, n, N / 64);
+        }
+    }
+}
+
+inline void orReduce(dynamicBitset &dst, const std::vector<dynamicBitset> &srcs)
+{
+    std::vector<const uint64_t *> words(srcs.size());
+    for (size_t i = 0; i < srcs.size(); i++)
+        words[i] = srcs[i].words.data();
+    maskKernels.orReduce(dst.words.data(), words.data(), words.size(), dst.words.size());
+}
@@ -0,0 +1,229 @@
+/**
+ * @file maskPool.h
+ * @brief Append-only pool of interned fragment masks, so that fragments can be referred to by 32-bit IDs
+ */
+#pragma once
+#include <bitset>             // for bitset
+#include <cstddef>            // for size_t
+#include <cstdint>            // for uint32_t, uint64_t
+#include <memory>             // for unique_ptr
+#include <utility>            // for pair
+#include <vector>             // for vector
+#include "dynamicBitset.h"    // for dynamicBitset
+#include "globalPrimitives.h" // for standardBitset, maskId, pii
+#include "maskKernels.h"      // for maskWords
+
+/**
+ * @brief Hash of a mask of words 64-bit words. Each word is mixed in with one multiply and shift, far cheaper
+ * than a byte-wise hash over the whole mask and good enough for the index of maskPool
+ */
+inline size_t mixMaskWords(const uint64_t *w, size_t words)
+{
+    uint64_t h = 0;
+    for (size_t i = 0; i < words; i++)
+    {
+        h = (h ^ w[i]) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+template <size_t N>
+inline size_t maskHash(const std::bitset<N> &mask)
+{
+    return mixMaskWords(maskWords(mask), N / 64);
+}
+
+inline size_t maskHash(const dynamicBitset &mask)
+{
+    return mixMaskWords(mask.words.data(), mask.words.size());
+}
+
+/**
+ * @brief Append-only pool of masks with hash-consing: interning a mask that is already in the pool returns the ID
+ * it was given the first time, so equal masks always have equal IDs and can be compared as integers.
+ * Masks are stored in chunks that never move, so a reference to a pooled mask stays valid as the pool grows and
+ * masks can be read by ID without locking. Interning and lookups by value must not run concurrently with
+ * interning, the callers hold canonMutex
+ */
+template <size_t W>
+struct maskPool
+{
+    static constexpr size_t CHUNK_BITS = 12, CHUNK_SIZE = size_t(1) << CHUNK_BITS, MAX_CHUNKS = size_t(1) << 16;
+    static constexpr maskId EMPTY = ~maskId(0);
+
+    /// @brief the chunks of masks, MAX_CHUNKS are reserved up front so that the chunk pointers never move
+    std::vector<std::unique_ptr<standardBitset<W>[]>> chunks;
+    /// @brief number of masks in the pool
+    size_t count = 0;
+    /// @brief open-addressing index from masks to their IDs, EMPTY for a free slot. Kept at most half full
+    std::vector<maskId> slots;
+
+    maskPool() { chunks.reserve(MAX_CHUNKS); }
+
+    /**
+     * @brief The mask with ID id
+     */
+    const standardBitset<W> &operator[](maskId id) const { return chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)]; }
+
+    size_t size() const { return count; }
+
+    /**
+     * @brief Finds the ID of mask
+     *
+     * @return false if the mask is not in the pool
+     */
+    bool find(const standardBitset<W> &mask, maskId &id) const
+    {
+        if (slots.empty())
+            return false;
+        size_t i = slotOf(mask);
+        while (slots[i] != EMPTY)
+        {
+            if ((*this)[slots[i]] == mask)
+            {
+                id = slots[i];
+                return true;
+            }
+            i = (i + 1) & (slots.size() - 1);
+        }
+        return false;
+    }
+
+    /**
+     * @brief The ID of mask, adding it to the pool if it is new
+     */
+    maskId intern(const standardBitset<W> &mask)
+    {
+        if ((count + 1) * 2 > slots.size())
+            rehash(slots.empty() ? 1024 : slots.size() * 2);
+        size_t i = slotOf(mask);
+        while (slots[i] != EMPTY)
+        {
+            if ((*this)[slots[i]] == mask)
+                return slots[i];
+            i = (i + 1) & (slots.size() - 1);
+        }
+        if ((count & (CHUNK_SIZE - 1)) == 0)
+            chunks.emplace_back(new standardBitset<W>[CHUNK_SIZE]);
+        maskId id = maskId(count);
+        chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)] = mask;
+        count++;
+        slots[i] = id;
+        return id;
+    }
+
+    /**
+     * @brief Size the index for n masks, so that interning them does not rehash
+     */
+    void reserve(size_t n)
+    {
+        size_t target = 1024;
+        while (target < 2 * n)
+            target <<= 1;
+        if (target > slots.size())
+            rehash(target);
+    }
+
+    /**
+     * @brief Remove every mask. IDs handed out before are no longer valid
+     */
+    void clear()
+    {
+        chunks.clear();
+        slots.clear();
+        count = 0;
+    }
+
+private:
+    size_t slotOf(const standardBitset<W> &mask) const
+    {
+        return maskHash(mask) & (slots.size() - 1);
+    }
+
+    void rehash(size_t size)
+    {
+        slots.assign(size, EMPTY);
+        for (size_t id = 0; id < count; id++)
+        {
+            size_t i = slotOf((*this)[maskId(id)]);
+            while (slots[i] != EMPTY)
+                i = (i + 1) & (slots.size() - 1);
+            slots[i] = maskId(id);
+        }
+    }
+};
+
+/// Every fragment mask of the current molecule, for masks W bits wide
+template <size_t W>
+inline maskPool<W> fragmentPool;
+
+/**
+ * @brief Canonical index and index within its isomorphism class of the canonised masks of a maskPool. Pool IDs are
+ * dense, so the table is a flat array indexed by ID: a lookup is a single load, and an entry costs no allocation
+ */
+struct canonTable
+{
+    /// @brief entry of each mask ID, UNSET for IDs without one
+    std::vector<pii> entries;
+    /// @brief number of IDs with an entry
+    size_t count = 0;
+
+    static constexpr pii UNSET = {-1, -1};
+
+    size_t size() const { return count; }
+
+    /**
+     * @brief One past the largest ID that may have an entry, the bound for iterating over the table
+     */
+    size_t idLimit() const { return entries.size(); }
+
+    /**
+     * @brief Finds the entry of id
+     *
+     * @return false if id has no entry
+     */
+    bool find(maskId id, pii &result) const
+    {
+        if (id >= entries.size() || entries[id] == UNSET)
+            return false;
+        result = entries[id];
+        return true;
+    }
+
+    /**
+     * @brief The entry of id, added as {0, 0} if id has none
+     *
+     * @return the entry, and true if it was added
+     */
+    std::pair<pii *, bool> tryEmplace(maskId id)
+    {
+        if (id >= entries.size())
+            entries.resize(size_t(id) + 1, UNSET);
+        pii &entry = entries[id];
+        bool added = entry == UNSET;
+        if (added)
+        {
+            entry = pii(0, 0);
+            count++;
+        }
+        return {&entry, added};
+    }
+
+    pii &operator[](maskId id) { return *tryEmplace(id).first; }
+
+    /**
+     * @brief Make room for the IDs below n, so that adding them does not reallocate
+     */
+    void reserve(size_t n) { entries.reserve(n); }
+
+    void clear()
+    {
+        entries.clear();
+        count = 0;
+    }
+};
+
+/// Hash table for edgelists for pathway algorithm, keyed by the ID of the edgelist in fragmentPool
+template <size_t W>
+inline canonTable bitsetHashTable;
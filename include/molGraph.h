@@ -4,22 +4,60 @@
  */
 #pragma once
 #include <stddef.h>           // for size_t
+#include <algorithm>          // for min, max
+#include <cstdint>            // for uint16_t, uint64_t, UINT16_MAX
 #include <iostream>           // for operator<<, basic_ostream, basic_ostre...
+#include <stdexcept>          // for length_error
 #include <string>             // for allocator, char_traits, basic_string
 #include <unordered_map>      // for unordered_map
 #include <utility>            // for pair
 #include <vector>             // for vector
-#include "globalPrimitives.h" // for edgeL, standardBitset, vb
+#include "globalPrimitives.h" // for edgeL, edgeIndex, labelId, standardBitset, vb
+
+/// Label of atoms marked for removal, which is never interned
+constexpr labelId REMOVED_LABEL = UINT16_MAX;
+
+/**
+ * @brief Dictionary of atom labels. Labels are interned as molecules are read, so the graph code only compares and
+ * copies IDs, and the strings are only looked up for output
+ */
+struct labelDictionary
+{
+    std::vector<std::string> names;
+    std::unordered_map<std::string, labelId> ids;
+
+    /**
+     * @brief ID of a label, the next one if it has not been seen before. Throws length_error once every ID below
+     * REMOVED_LABEL is taken
+     */
+    labelId intern(const std::string &name)
+    {
+        auto it = ids.find(name);
+        if (it == ids.end())
+        {
+            if (names.size() >= REMOVED_LABEL)
+                throw std::length_error("more than " + std::to_string(REMOVED_LABEL) + " distinct atom labels");
+            it = ids.emplace(name, labelId(names.size())).first;
+            names.push_back(name);
+        }
+        return it->second;
+    }
+
+    const std::string &name(labelId id) const { return names[id]; }
+};
+
+/// Labels of the atoms of every molecule read
+extern labelDictionary atomLabels;
 
 /**
  * @brief Bond struct for molGraph
  */
 struct bond
 {
-    short n;
+    edgeIndex n;
     short type;
     bond() {}
-    bond(short _n, short _type) : n(_n), type(_type) {}
+    bond(edgeIndex _n, short _type) : n(_n), type(_type) {}
 };
 
 /**
@@ -27,11 +65,11 @@ struct bond
  */
 struct atom
 {
-    std::string type;
+    labelId type;
     std::vector<bond> list;
 
     atom() {}
-    atom(std::string _type) : type(_type) {}
+    atom(labelId _type) : type(_type) {}
 };
 
 /**
@@ -52,10 +90,17 @@ struct molGraph
      * @brief Use this function to add atoms/nodes
      * @param _type Type is atom type/node labelling.
      */
-    void addAtom(std::string &_type)
+    void addAtom(const std::string &_type)
     {
-        atom a(_type);
-        mg.push_back(a);
+        addAtom(atomLabels.intern(_type));
+    }
+
+    /**
+     * @brief Add an atom with a label already in atomLabels
+     */
+    void addAtom(labelId _type)
+    {
+        mg.emplace_back(_type);
     }
 
     /**
@@ -80,7 +125,7 @@ struct molGraph
         std::cout << "There are " << mg.size() << " atoms in the molecule-graph\n";
         for (size_t i = 0; i < mg.size(); i++)
         {
-            std::cout << "Atom " << i + 1 << " is of type " << mg[i].type << " and adjacent to atoms ";
+            std::cout << "Atom " << i + 1 << " is of type " << atype(i) << " and adjacent to atoms ";
             for (size_t j = 0; j < degree(i); j++)
             {
                 std::cout << elem(i, j) + 1 << " with bond order " << btypeS(i, j) << ", ";
@@ -97,7 +142,7 @@ struct molGraph
         return mg[x].list.size();
     }
 
-    short elem(size_t a, size_t b)
+    edgeIndex elem(size_t a, size_t b)
     {
         return mg[a].list[b].n;
     }
@@ -105,7 +150,7 @@ struct molGraph
     /**
      * @brief Get atom type for index i
      */
-    std::string atype(size_t i) { return mg[i].type; }
+    const std::string &atype(size_t i) { return atomLabels.name(mg[i].type); }
 
     /**
      * @brief Get bond type as char
@@ -170,7 +215,7 @@ struct molGraph
     {
         if (i >= mg.size())
             return false;
-        mg[i].type = "COLLAPSE";
+        mg[i].type = REMOVED_LABEL;
         return true;
     }
 
@@ -185,7 +230,7 @@ struct molGraph
         molGraph output;
         for (size_t i = 0; i < originalSize; i++)
         {
-            if (mg[i].type != "COLLAPSE")
+            if (mg[i].type != REMOVED_LABEL)
             {
                 revmap[i] = map.size();
                 map.push_back(i);
@@ -216,11 +261,11 @@ struct molGraph
     std::vector<edgeL> writeEdgeList()
     {
         std::vector<edgeL> out;
-        for (short i = 0; i < mg.size(); i++)
+        for (edgeIndex i = 0; i < edgeIndex(mg.size()); i++)
         {
-            for (short j = 0; j < degree(i); j++)
+            for (edgeIndex j = 0; j < edgeIndex(degree(i)); j++)
             {
-                short k = elem(i, j);
+                edgeIndex k = elem(i, j);
                 if (i < k)
                 {
                     edgeL t(i, k, j);
@@ -232,22 +277,21 @@ struct molGraph
     }
 
     /**
-     * @brief For preprocessing, writes edgeList as hash map to detect duplicated bonds
+     * @brief For preprocessing, writes edgeList as hash map to detect duplicated bonds. Bonds are keyed by the labels
+     * of their atoms, smaller first, and their bond type
      */
-    void writeEdgeList(std::unordered_map<std::string, std::pair<int, edgeL>> &ht)
+    void writeEdgeList(std::unordered_map<uint64_t, std::pair<int, edgeL>> &ht)
     {
-        for (short i = 0; i < mg.size(); i++)
+        for (edgeIndex i = 0; i < edgeIndex(mg.size()); i++)
         {
-            for (short j = 0; j < degree(i); j++)
+            for (edgeIndex j = 0; j < edgeIndex(degree(i)); j++)
             {
-                short k = elem(i, j);
+                edgeIndex k = elem(i, j);
                 if (i < k)
                 {
-                    std::string is = atype(i), ks = atype(k), out;
-                    if (is < ks)
-                        out = is + btype(i, j) + ks;
-                    else
-                        out = ks + btype(i, j) + is;
+                    labelId is = mg[i].type, ks = mg[k].type;
+                    uint64_t out = uint64_t(std::min(is, ks)) << 32 | uint64_t(uint16_t(btypeS(i, j))) << 16 |
+                                   std::max(is, ks);
                     edgeL t(i, k, j);
                     if (ht.count(out) == 0)
                     {
@@ -309,6 +353,33 @@ struct molGraph
     }
 };
 
+/**
+ * @brief Graph as compressed sparse rows with atom types as integer codes, for the canonical labelling and
+ * isomorphism code, which only compare labels and follow bonds
+ */
+struct labelledGraph
+{
+    int n = 0;
+    /// @brief atom label of each vertex, as in atomLabels
+    vi type;
+    /// @brief the neighbours of v are nbr[start[v]] to nbr[start[v + 1] - 1], joined by bonds of type btype
+    vi start, nbr, btype;
+
+    int degree(int v) const { return start[v + 1] - start[v]; }
+};
+
+/**
+ * @brief The labelledGraph of a whole molGraph, with the same vertex numbering
+ */
+labelledGraph toLabelledGraph(molGraph &mg);
+
+/**
+ * @brief The labelledGraph of the subgraph of mg made of the bonds of edgeList set in mask, read off mg without
+ * building a molGraph of the subgraph
+ */
+template <size_t W>
+labelledGraph toLabelledGraph(molGraph &mg, const std::vector<edgeL> &edgeList, const standardBitset<W> &mask);
+
 /**
  * @brief construct new molGraph from input molGraph and boolean edgelist
  *
@@ -318,8 +389,9 @@ struct molGraph
  * @param isCyclic Is the graph cyclic, needed for hashing
  * @return molGraph
  */
+template <size_t W>
 molGraph constructFromEdgeList(molGraph &mg, std::vector<edgeL> &edgeList,
-                               standardBitset &mask, bool &isCyclic);
+                               standardBitset<W> &mask, bool &isCyclic);
 /**
  * @brief Preprocesses the graph by removing all unique edges for the pathway algorithm
  * @param mg The input molGraph
@@ -337,5 +409,6 @@ extern molGraph originalMolecule, targetMolecule;
  * @param mask Target bitset as input
  * @param maskList List of disjoint bitsets returned
  */
-void ufdsMaskConstruct(standardBitset &mask,
-                       std::vector<standardBitset> &maskList);
\ No newline at end of file
+template <size_t W>
+void ufdsMaskConstruct(standardBitset<W> &mask,
+                       std::vector<standardBitset<W>> &maskList);
\ No newline at end of file
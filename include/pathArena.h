@@ -0,0 +1,52 @@
+/**
+ * @file pathArena.h
+ * @brief Slab allocator for assemblyPath nodes, so that a whole pathway hash table can be released at once
+ */
+#pragma once
+#include <cstddef>         // for size_t
+#include <mutex>           // for mutex
+#include <vector>          // for vector
+#include "assemblyState.h" // for assemblyPath, pathPtr, stateKey
+
+/**
+ * @brief Carves assemblyPath nodes and their keys out of large slabs. Nodes released one at a time, e.g. when
+ * evicted from a bounded table, go on a free list per key size to be reused. reset() releases every node at once
+ * by freeing the slabs, without visiting the nodes.
+ */
+struct pathArena
+{
+    std::mutex lock;
+    /// @brief every slab allocated since the last reset
+    std::vector<char *> slabs;
+    /// @brief unused part of the newest slab
+    char *next = nullptr, *end = nullptr;
+    /// @brief heads of the free lists, indexed by key size. A free block stores the next free block in its first bytes
+    std::vector<char *> freeBlocks;
+
+    pathArena() {}
+    pathArena(const pathArena &) = delete;
+    pathArena &operator=(const pathArena &) = delete;
+    ~pathArena();
+
+    /**
+     * @brief Construct a node with no references
+     *
+     * @param key Canonical key of the state, copied into the arena
+     * @param sumDupBonds Number of duplicated bonds on the pathway to the state
+     * @param parent Node of the state this one was generated from
+     * @param match Index of the retained duplicate within its isomorphism class
+     * @param duplicate Index of the removed duplicate within its isomorphism class
+     */
+    assemblyPath *create(const stateKey &key, int sumDupBonds, const pathPtr &parent,
+                         unsigned short match, unsigned short duplicate);
+
+    /**
+     * @brief Destroy a node whose last reference has gone and recycle its memory
+     */
+    void destroy(assemblyPath *ap);
+
+    /**
+     * @brief Release every node of the arena. No references to them may remain
+     */
+    void reset();
+};
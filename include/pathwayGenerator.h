@@ -20,9 +20,10 @@ struct reconstructedState
 /**
  * @brief Struct representing a pair of edge masks used during pathway reconstruction
  */
+template <size_t W>
 struct reconstructedEdgelist
 {
-    std::vector<standardBitset> list;
+    std::vector<standardBitset<W>> list;
     int assemblyIndex;
 };
 
@@ -37,7 +38,8 @@ extern std::vector<reconstructedState> minAssemblyPathway;
  * @param mask Bitset representing edges to output
  * @param ofs Output file stream
  */
-void printMaskAsEdgeList(standardBitset mask, std::ofstream &ofs);
+template <size_t W>
+void printMaskAsEdgeList(standardBitset<W> mask, std::ofstream &ofs);
 
 /**
  * @brief Subroutine of the pathway reconstruction function
@@ -52,7 +54,8 @@ void printMaskAsEdgeList(std::ofstream &ofs);
  * @param maskList List of two bitsets (matching pair)
  * @param ofs Output file stream
  */
-void printMatching(std::vector<standardBitset> &maskList, std::ofstream &ofs);
+template <size_t W>
+void printMatching(std::vector<standardBitset<W>> &maskList, std::ofstream &ofs);
 
 /**
  * @brief Subroutine of the pathway reconstruction function
@@ -67,7 +70,8 @@ void printOriginalGraph(std::ofstream &ofs);
  * @param mask Bitset representing edges to remove from original molecule
  * @param ofs Output file stream
  */
-void printRemnantGraph(standardBitset mask, std::ofstream &ofs);
+template <size_t W>
+void printRemnantGraph(standardBitset<W> mask, std::ofstream &ofs);
 
 /**
  * @brief Pathway reconstruction function, which outputs the original graph, remnants and duplicates to a file
@@ -76,4 +80,5 @@ void printRemnantGraph(standardBitset mask, std::ofstream &ofs);
  *
  * @param removedEdges Edges that were removed during assembly
  */
+template <size_t W>
 void recoverPathway2(std::vector<edgeL> &removedEdges);
\ No newline at end of file
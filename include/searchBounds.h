@@ -0,0 +1,55 @@
+/**
+ * @file searchBounds.h
+ * @brief Tracks the lower bounds of the parts of the search tree that have not been completed, giving a proven
+ * lower bound on the assembly index at any point of the search
+ */
+#pragma once
+#include <atomic> // for atomic
+#include <memory> // for unique_ptr
+
+/**
+ * @brief Histogram of the lower bounds of open subtrees. A subtree is opened when it is queued or about to be
+ * searched and closed once it has been searched to completion, so every pathway not yet explored passes through
+ * an open subtree and the smallest open bound is a lower bound on the assembly index
+ */
+struct searchBounds
+{
+    /// @brief number of open subtrees with each bound, indexed by bound
+    std::unique_ptr<std::atomic<long long>[]> open;
+    /// @brief number of entries in open
+    int range = 0;
+    /// @brief largest lower bound reported so far
+    std::atomic<int> reported{0};
+
+    /**
+     * @brief Clear all open subtrees
+     *
+     * @param maxBound Largest bound that will be recorded, larger bounds are clamped to it
+     */
+    void reset(int maxBound);
+
+    /**
+     * @brief Record a subtree with lower bound bound as open
+     */
+    void openBound(int bound);
+
+    /**
+     * @brief Record a subtree with lower bound bound as completely searched
+     */
+    void closeBound(int bound);
+
+    /**
+     * @brief The proven lower bound on the assembly index
+     *
+     * @param incumbent Smallest assembly index found so far
+     * @return int the smaller of the incumbent and the smallest open bound
+     */
+    int lowerBound(int incumbent);
+
+private:
+    /// @brief clamp a bound to [0, range)
+    int slot(int bound);
+};
+
+/// Open subtrees of the current search
+extern searchBounds openBounds;
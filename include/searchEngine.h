@@ -0,0 +1,129 @@
+/**
+ * @file searchEngine.h
+ * @brief Depth-first branch and bound on an explicit stack, so that a search can be suspended after a number of
+ * expansions and resumed later
+ */
+#pragma once
+#include <atomic>              // for atomic
+#include <cstddef>             // for size_t
+#include <vector>              // for vector
+#include "assemblyState.h"     // for assemblyState
+#include "duplicateMatching.h" // for validMatchings
+
+/**
+ * @brief Masks of a duplicate set that bound its children once they are fragmented: the union of the set's
+ * duplicates, and of the duplicates of every set of its level enumerated up to it
+ */
+template <size_t W>
+struct duplicateSetMasks
+{
+    standardBitset<W> matchMask, maxFragMask;
+    duplicateSetMasks() {}
+    duplicateSetMasks(standardBitset<W> &_matchMask, standardBitset<W> &_maxFragMask)
+        : matchMask(_matchMask), maxFragMask(_maxFragMask) {}
+};
+
+/**
+ * @brief Child generated by an expansion, kept as the matching that generates it. It is only fragmented, and then
+ * claimed in the pathway hash table, when it is about to be searched
+ */
+template <size_t W>
+struct rankedChild
+{
+    validMatchings<W> matching;
+    /// @brief lower bound of the child's duplicate set before fragmentation, raised to the child's own bound
+    /// once it is fragmented
+    int bound;
+    /// @brief index of the masks of the child's duplicate set
+    int set;
+    rankedChild() {}
+    rankedChild(validMatchings<W> &_matching, int _bound, int _set) : matching(_matching), bound(_bound), set(_set) {}
+};
+
+/**
+ * @brief Orders children so that the lowest bound comes first. Ties go to the child with the larger duplicate, which
+ * duplicates more bonds
+ */
+struct compareRankedChild
+{
+    template <size_t W>
+    bool operator()(const rankedChild<W> &a, const rankedChild<W> &b) const
+    {
+        if (a.bound != b.bound)
+            return a.bound < b.bound;
+        return a.matching.maxFragSize > b.matching.maxFragSize;
+    }
+};
+
+/**
+ * @brief One level of the search. The state is expanded the first time the frame reaches the top of the stack,
+ * after which its children are searched one at a time
+ */
+template <size_t W>
+struct searchFrame
+{
+    assemblyState<W> state;
+    /// @brief lower bound on the assembly index through state
+    int bound = 0;
+    /// @brief children left by the expansion, searched in order, and the masks of their duplicate sets
+    std::vector<rankedChild<W>> children;
+    std::vector<duplicateSetMasks<W>> sets;
+    /// @brief index of the next child to search
+    size_t next = 0;
+    bool expanded = 0;
+
+    searchFrame() {}
+    searchFrame(assemblyState<W> &_state) : state(_state) {}
+};
+
+/**
+ * @brief Depth-first search of the subtree of one assembly state with heap-resident frames in place of recursion.
+ *
+ * The engine keeps openBounds up to date with the part of the subtree it has not searched: the bound of each frame
+ * that has not been expanded, and of each child that has not been searched yet. An expanded state is replaced by
+ * its children, so the proven lower bound rises as the subtree is searched and not only once it is complete
+ */
+template <size_t W>
+struct searchEngine
+{
+    std::vector<searchFrame<W>> stack;
+    /// @brief the global minimum assembly index found, shared by all search threads
+    std::atomic<int> &AI;
+    /// @brief number of states expanded so far
+    size_t nodes = 0;
+
+    /**
+     * @param root The state whose subtree is searched, already claimed in the pathway hash table
+     * @param bound Lower bound on the assembly index through root, already opened in openBounds
+     * @param _AI The global minimum assembly index found
+     */
+    searchEngine(assemblyState<W> &root, int bound, std::atomic<int> &_AI);
+
+    /**
+     * @brief Continue the search
+     *
+     * @param maxNodes Number of states that may be expanded before the engine yields, 0 for no limit
+     * @return true once the subtree has been searched completely
+     * @return false if the engine yielded or the search was interrupted, in which case it can be run again
+     */
+    bool run(size_t maxNodes = 0);
+
+    /**
+     * @brief Continue from the stack of a checkpoint in place of the root, opening the bounds of its unsearched
+     * states in openBounds
+     *
+     * @param saved Stack read from a checkpoint of this root, swapped into the engine
+     */
+    void resume(std::vector<searchFrame<W>> &saved);
+
+    /**
+     * @brief Drop the rest of the subtree once the incumbent has reached the bound of the root, closing the
+     * bounds still open in openBounds
+     */
+    void prune();
+
+    /**
+     * @brief Whether the subtree has been searched completely
+     */
+    bool done() { return stack.empty(); }
+};
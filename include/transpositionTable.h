@@ -0,0 +1,123 @@
+/**
+ * @file transpositionTable.h
+ * @brief Concurrent hash table of assembly states used to detect states reached by more than one pathway
+ */
+#pragma once
+#include <atomic>          // for atomic
+#include <cstddef>         // for size_t
+#include <mutex>           // for mutex
+#include <vector>          // for vector
+#include "assemblyState.h" // for assemblyPath, pathPtr, stateKey
+#include "pathArena.h"     // for pathArena
+
+/**
+ * @brief Slot of the open addressing table. Empty while ap is nullptr. An occupied slot holds one reference to ap
+ */
+struct ttSlot
+{
+    /// @brief fingerprint of ap->key, kept so that probing and growing do not rehash keys, and compared before the keys
+    size_t hash = 0;
+    assemblyPath *ap = nullptr;
+};
+
+/**
+ * @brief One shard of the table, an open addressing hash table with linear probing behind its own lock
+ */
+struct ttShard
+{
+    std::mutex lock;
+    /// @brief size is always a power of two
+    std::vector<ttSlot> slots;
+    /// @brief number of occupied slots
+    size_t used = 0;
+    /// @brief approximate memory used by the entries
+    size_t bytes = 0;
+    /// @brief next slot the eviction sweep looks at
+    size_t hand = 0;
+    /// @brief nodes of the shard are allocated here
+    pathArena arena;
+};
+
+/**
+ * @brief Sharded transposition table mapping the canonical key of an assembly state to its assemblyPath.
+ * The shard is chosen from the high bits of the key hash, so threads only contend when they touch the same shard.
+ * With a memory limit, a full shard evicts entries to make room. Forgetting a state only means it is searched
+ * again if it is reached again, so the search stays exact.
+ */
+struct transpositionTable
+{
+    /// @brief log2 of the number of shards
+    static constexpr int SHARD_BITS = 6;
+    static constexpr size_t SHARDS = size_t(1) << SHARD_BITS;
+
+    ttShard shards[SHARDS];
+    /// @brief memory each shard may use, 0 for no limit
+    size_t shardBudget = 0;
+    /// @brief number of entries evicted since the last clear
+    std::atomic<size_t> evictions{0};
+
+    /**
+     * @brief Single-probe lookup-or-insert. If the key is new, a node is created with the given values.
+     * If the key exists but was reached with fewer duplicated bonds, the node is updated to this pathway.
+     *
+     * @param key Canonical key of the state, copied into the table if it is new
+     * @param sumDupBonds Number of duplicated bonds on the pathway to the state
+     * @param parent Node of the state this one was generated from
+     * @param match Index of the retained duplicate within its isomorphism class
+     * @param duplicate Index of the removed duplicate within its isomorphism class
+     * @return pathPtr the node of the state if it has to be searched, nullptr if it has already been
+     * reached with at least as many duplicated bonds
+     */
+    pathPtr tryClaim(const stateKey &key, int sumDupBonds, const pathPtr &parent,
+                     unsigned short match, unsigned short duplicate);
+
+    /**
+     * @brief Look up a key without inserting it
+     *
+     * @return pathPtr the node of the key, nullptr if it is not in the table
+     */
+    pathPtr find(const stateKey &key);
+
+    /**
+     * @brief Create a node that is not entered in the table, in the arena of the shard its key belongs to.
+     * It is released by clear() like the nodes of the table
+     */
+    pathPtr makeNode(const stateKey &key, int sumDupBonds, const pathPtr &parent,
+                     unsigned short match, unsigned short duplicate);
+
+    /**
+     * @brief All nodes in the table, in no particular order. Not safe while other threads insert
+     */
+    std::vector<pathPtr> nodes();
+
+    /**
+     * @brief Bound the memory used by the entries of the table
+     *
+     * @param bytes Approximate limit, 0 for none
+     */
+    void setMemoryLimit(size_t bytes);
+
+    /**
+     * @brief Number of states stored
+     */
+    size_t size();
+
+    /**
+     * @brief Drop all nodes and empty the table. The arenas are released whole rather than node by node, so no
+     * pathPtr to a node of the table may be left
+     */
+    void clear();
+
+private:
+    /// @brief double the slots of a shard, called with the shard lock held
+    void grow(ttShard &s);
+    /// @brief remove the entry in slot i, shifting back the entries probed past it
+    void erase(ttShard &s, size_t i);
+    /// @brief remove one entry chosen by the eviction sweep
+    void evict(ttShard &s);
+};
+
+/// Hash table for assembly states for pathway algorithm
+extern transpositionTable pathAssemblyMap;
+/// Hash table for the states of the greedy dive, kept apart from pathAssemblyMap
+extern transpositionTable diveMap;
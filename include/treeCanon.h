@@ -3,47 +3,23 @@
  * @brief tree canonisation code
  */
 #pragma once
-#include <string>             // for string
-#include <vector>             // for vector
-#include "globalPrimitives.h" // for pii
-struct molGraph;
+#include <cstdint> // for uint32_t
+struct labelledGraph;
 
 /**
- * @brief Subroutine of tree canonisation function
+ * @brief Canonical key of a tree, by AHU tree canonisation from its centroid. Each subtree is numbered by the atom
+ * type of its root and the bond types and numbers of the subtrees below it, through a table shared by all trees, so
+ * two trees get the same key if and only if they are isomorphic with the same atom and bond types. A tree with two
+ * centroids is numbered by the bond between them and the two halves either side of it.
  *
- * @param mg Molecular graph (assumed to be a tree)
- * @param curr Current node index
- * @param parent Parent node index
- * @param type Bond type leading to this node
- * @return Canonical string for subtree rooted at curr
- */
-std::string treeCanonRecursive(molGraph &mg, int curr, int parent, char type);
-
-/**
- * @brief Subroutine of centroid finding function
- *
- * @param mg Molecular graph
- * @param weight Vector of subtree weights
- * @param curr Current node index
- * @param prev Previous node index
- * @return Subtree size rooted at curr
- */
-int centroidDFS(molGraph &mg, std::vector<int> &weight, int curr, int prev);
-
-/**
- * @brief Subroutine of tree canonisation function, finds centroid
+ * The table is shared, so callers hold canonMutex
  *
- * @param mg Molecular graph
- * @param currRoot Starting index to search for centroid
- * @return Pair of centroid(s) (second = -1 if only one)
+ * @param g Connected acyclic graph
+ * @return uint32_t canonical key
  */
-pii centroid(molGraph &mg, int currRoot);
+uint32_t treeCanonKey(const labelledGraph &g);
 
 /**
- * @brief Function to find a canonical string for a tree, using standard tree canonisation algorithm
- *
- * @param mg Acyclic molGraph
- * @param n Starting index
- * @return string (canonical form)
+ * @brief Empties the table of subtree numbers, after which keys are not comparable with those computed before
  */
-std::string centroidTreeCanon(molGraph &mg, int n);
\ No newline at end of file
+void clearTreeCanon();
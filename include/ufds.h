@@ -156,10 +156,11 @@ struct ufdsSplit
      *
      * @param maskList The output
      */
-    void split(std::vector<standardBitset> &maskList)
+    template <size_t W>
+    void split(std::vector<standardBitset<W>> &maskList)
     {
         vi uniques(maxElement + 1, -1);
-        std::vector<standardBitset> tempMaskList;
+        std::vector<standardBitset<W>> tempMaskList;
         for (size_t i = 0; i <= maxElement; i++)
         {
             if (elements[i].parent != -1)
@@ -168,7 +169,7 @@ struct ufdsSplit
                 if (uniques[elements[i].parent] == -1)
                 {
                     uniques[elements[i].parent] = tempMaskList.size();
-                    standardBitset b = 0;
+                    standardBitset<W> b = 0;
                     b.set(elements[i].val);
                     tempMaskList.push_back(b);
                 }
@@ -1,20 +1,20 @@
 /**
  * @file vf2.h
- * @brief code to utilise boost vf2 graph isomorphism algorithm
+ * @brief vf2 graph isomorphism, native on labelledGraph and through boost
  */
 #pragma once
 #include <boost/graph/adjacency_list.hpp>            // for adjacency_list
-#include <string>                                    // for basic_string
 #include <vector>                                    // for vector
 #include "boost/graph/graph_selectors.hpp"           // for undirectedS
 #include "boost/graph/mcgregor_common_subgraphs.hpp" // for property_map_eq...
 #include "boost/graph/properties.hpp"                // for edge_name_t
 #include "boost/iterator/iterator_facade.hpp"        // for operator!=
 #include "boost/pending/property.hpp"                // for property, no_pr...
-#include "globalPrimitives.h"                        // for edgeL, standard...
+#include "globalPrimitives.h"                        // for edgeL, labelId,...
 struct molGraph;
+struct labelledGraph;
 typedef boost::property<boost::edge_name_t, char> bond_vf2;
-typedef boost::property<boost::vertex_name_t, std::string, boost::property<boost::vertex_index_t, int>> atom_vf2;
+typedef boost::property<boost::vertex_name_t, labelId, boost::property<boost::vertex_index_t, int>> atom_vf2;
 typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS, atom_vf2, bond_vf2> molGraphBoost;
 typedef boost::property_map<molGraphBoost, boost::vertex_name_t>::type vertex_name_map_t;
 typedef boost::property_map_equivalent<vertex_name_map_t, vertex_name_map_t> vertex_comp_t;
@@ -29,7 +29,8 @@ typedef boost::property_map_equivalent<edge_name_map_t, edge_name_map_t> edge_co
  * @param mask The input boolean edgelist
  * @return molGraphBoost the output
  */
-molGraphBoost edgelistToBoost(molGraph &mg, std::vector<edgeL> &edgeList, const standardBitset &mask);
+template <size_t W>
+molGraphBoost edgelistToBoost(molGraph &mg, std::vector<edgeL> &edgeList, const standardBitset<W> &mask);
 
 /**
  * @brief vf2 graph isomorphism caller
@@ -39,4 +40,17 @@ molGraphBoost edgelistToBoost(molGraph &mg, std::vector<edgeL> &edgeList, const
  * @return true if the two graphs are isomorphic
  * @return false otherwise
  */
-bool vf2GraphIso(molGraphBoost &mmg, molGraphBoost &tmg);
\ No newline at end of file
+bool vf2GraphIso(molGraphBoost &mmg, molGraphBoost &tmg);
+
+/**
+ * @brief Native vf2 isomorphism test, matching atom and bond types. The vertices of the first graph are matched in
+ * breadth first order from a vertex of its rarest atom type and degree, so every vertex after the first of its
+ * component is tried only against the neighbours of the image of a matched neighbour. Candidates must agree in atom
+ * type and degree, and in the bonds to the vertices matched so far. The state arrays are allocated once per call
+ *
+ * @param g1 First graph to be compared
+ * @param g2 Second graph to be compared
+ * @return true if the two graphs are isomorphic
+ * @return false otherwise
+ */
+bool vf2GraphIso(const labelledGraph &g1, const labelledGraph &g2);
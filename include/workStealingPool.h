@@ -0,0 +1,95 @@
+/**
+ * @file workStealingPool.h
+ * @brief Work-stealing thread pool used by the parallel branch-and-bound search
+ */
+#pragma once
+#include <atomic>          // for atomic
+#include <cstddef>         // for size_t
+#include <deque>           // for deque
+#include <functional>      // for function
+#include <mutex>           // for mutex
+#include <vector>          // for vector
+#include "assemblyState.h" // for assemblyState
+
+/**
+ * @brief An assembly state waiting to be searched, together with the lower bound it was queued with
+ */
+template <size_t W>
+struct searchTask
+{
+    /// @brief the state whose subtree is to be searched
+    assemblyState<W> state;
+    /// @brief lower bound on the assembly index of any pathway through this state
+    int bound = 0;
+
+    searchTask() {}
+    searchTask(assemblyState<W> &_state, int _bound) : state(_state), bound(_bound) {}
+};
+
+/**
+ * @brief Per-thread double ended task queue. The owner pushes and pops at the back (depth first),
+ * other workers steal from the front, where the oldest and usually largest subtrees are
+ */
+template <size_t W>
+struct workerQueue
+{
+    std::deque<searchTask<W>> tasks;
+    std::mutex lock;
+    /// @brief copy of tasks.size() that can be read without taking the lock
+    std::atomic<size_t> size{0};
+};
+
+/**
+ * @brief Work-stealing pool of search threads. Subtrees spawned from a worker go to that worker's queue,
+ * idle workers steal from the queues of others. The calling thread takes part as worker 0.
+ */
+template <size_t W>
+struct workStealingPool
+{
+    /// @brief one queue per worker
+    std::vector<workerQueue<W>> queues;
+    /// @brief tasks that have been queued but have not finished executing
+    std::atomic<long long> pending{0};
+    /// @brief next queue that submit() places a task on
+    size_t nextQueue = 0;
+
+    workStealingPool(size_t threads) : queues(threads) {}
+
+    /**
+     * @brief Queue a task before the pool is running. Tasks are dealt round-robin across the workers and
+     * each worker takes its tasks in submission order
+     *
+     * @param as The state to be searched
+     * @param bound Lower bound on the assembly index through this state
+     */
+    void submit(assemblyState<W> &as, int bound);
+
+    /**
+     * @brief Called from inside a search task. Queues the state on the calling worker's queue if that queue
+     * is running low on stealable work
+     *
+     * @param as The state to be searched
+     * @param bound Lower bound on the assembly index through this state
+     * @return true if the state was queued, false if the caller should search it itself
+     */
+    bool trySpawn(assemblyState<W> &as, int bound);
+
+    /**
+     * @brief Start the workers and block until every queued task, and every task spawned from them, is done
+     *
+     * @param execute Function that searches a single task
+     */
+    void run(const std::function<void(searchTask<W> &)> &execute);
+
+private:
+    /// @brief pop from the back of the worker's own queue
+    bool popLocal(size_t worker, searchTask<W> &t);
+    /// @brief take a task from the front of another worker's queue
+    bool steal(size_t worker, searchTask<W> &t);
+    /// @brief loop run by each worker thread
+    void workerLoop(size_t worker, const std::function<void(searchTask<W> &)> &execute);
+};
+
+/// Pool used by dagRecursiveAssembly to spawn subtrees. nullptr when the search runs on a single thread
+template <size_t W>
+inline workStealingPool<W> *searchPool = nullptr;
@@ -8,30 +8,44 @@
 #include <locale>        // for num_get, num_put, numpunct
 #include <string>        // for char_traits
 #include <unordered_map> // for unordered_map
-#include <unordered_set> // for unordered_set
 #include <utility>       // for pair
 #include <vector>        // for vector
+#include "graphHashes.h" // for findCanonical
 #include "molGraph.h"    // for constructFromEdgeList, molGraph, targetMole...
 
 using namespace std;
 
-assemblyPath *minAssemblyPath = nullptr;
+pathPtr minAssemblyPath;
 
-std::unordered_set<apWrapper> pathAssemblyMap;
+template <size_t W>
+void assemblyState<W>::describeFragments()
+{
+    frags.resize(masks.size());
+    idSum = 0;
+    for (size_t i = 0; i < masks.size(); i++)
+    {
+        pii p;
+        frags[i].size = masks[i].count();
+        frags[i].canon = findCanonical<W>(masks[i], p) ? p.first : -1;
+        idSum += stateKey::idKey(frags[i].canon);
+    }
+}
 
-int assemblyState::maxFragSizeF()
+template <size_t W>
+int assemblyState<W>::maxFragSizeF()
 {
-    return masks[0].count();
+    return frags[0].size;
 }
 
-int assemblyState::maxDupBonds()
+template <size_t W>
+int assemblyState<W>::maxDupBonds()
 {
     int dupBonds2 = 0, dupBondsTotal, maxFragSize = maxFragSizeF();
     vi sizeList(masks.size());
 
     for (size_t i = 0; i < masks.size(); i++)
     {
-        sizeList[i] = masks[i].count();
+        sizeList[i] = frags[i].size;
     }
 
     for (size_t i = 0; i < sizeList.size(); i++)
@@ -53,7 +67,8 @@ int assemblyState::maxDupBonds()
     return dupBonds2;
 }
 
-int assemblyState::maxDupBonds(vi &sizeListMain, int maxFragSize, vi &sizeList)
+template <size_t W>
+int assemblyState<W>::maxDupBonds(vi &sizeListMain, int maxFragSize, vi &sizeList)
 {
     int dupBonds2 = 0, dupBondsTotal;
 
@@ -76,7 +91,8 @@ int assemblyState::maxDupBonds(vi &sizeListMain, int maxFragSize, vi &sizeList)
     return dupBondsTotal;
 }
 
-int assemblyState::maxDupBonds(vi &sizeListMain, int maxFragSize, vector<standardBitset> &targetMasks)
+template <size_t W>
+int assemblyState<W>::maxDupBonds(vi &sizeListMain, int maxFragSize, vector<standardBitset<W>> &targetMasks)
 {
     int dupBonds2 = 0, dupBondsTotal;
     vi sizeList(targetMasks.size());
@@ -105,7 +121,8 @@ int assemblyState::maxDupBonds(vi &sizeListMain, int maxFragSize, vector<standar
     return dupBondsTotal;
 }
 
-void assemblyState::maxDupBonds(vi &fragSizeList, int maxFragSize, vector<vector<standardBitset>> &targetMasks)
+template <size_t W>
+void assemblyState<W>::maxDupBonds(vi &fragSizeList, int maxFragSize, vector<vector<standardBitset<W>>> &targetMasks)
 {
     int dupBonds2 = 0, dupBondsTotal;
     fragSizeList.resize(maxFragSize - 1);
@@ -147,14 +164,15 @@ void assemblyState::maxDupBonds(vi &fragSizeList, int maxFragSize, vector<vector
     }
 }
 
-int assemblyState::maxDupBonds(int maxFragSize)
+template <size_t W>
+int assemblyState<W>::maxDupBonds(int maxFragSize)
 {
     int dupBonds2 = 0, dupBondsTotal;
     vi sizeList(masks.size());
 
     for (size_t i = 0; i < masks.size(); i++)
     {
-        sizeList[i] = masks[i].count();
+        sizeList[i] = frags[i].size;
     }
 
     for (size_t i = 0; i < sizeList.size(); i++)
@@ -176,36 +194,34 @@ int assemblyState::maxDupBonds(int maxFragSize)
     return dupBonds2;
 }
 
-int assemblyState::lowBoundAI()
+template <size_t W>
+int assemblyState<W>::lowBoundAI()
 {
     return totalBonds - sumDupBonds - 1 - maxDupBonds();
 }
 
-int assemblyState::lowBoundAI(int maxFragSize, int estimate)
+template <size_t W>
+int assemblyState<W>::lowBoundAI(int maxFragSize, int estimate)
 {
     if (maxFragSize > 2)
         estimate = max(estimate, maxDupBonds(maxFragSize - 1));
     return totalBonds - sumDupBonds - 1 - estimate;
 }
 
-int assemblyState::AI()
+template <size_t W>
+int assemblyState<W>::AI()
 {
     return totalBonds - sumDupBonds - 1;
 }
 
-vi assemblyState::assemblyHashCalculator()
+template <size_t W>
+stateKey assemblyState<W>::assemblyHashCalculator()
 {
-    vi sorted(masks.size(), -1);
-    for (size_t i = 0; i < masks.size(); i++)
-    {
-        if (bitsetHashTable.count(masks[i]))
-            sorted[i] = bitsetHashTable[masks[i]].first;
-    }
-    sort(sorted.begin() + 1, sorted.end());
-    return sorted;
+    return stateKey(frags.size(), frags.empty() ? nullptr : &frags[0].canon, sizeof(frags[0]), idSum);
 }
 
-void assemblyState::print()
+template <size_t W>
+void assemblyState<W>::print()
 {
     cout << "printing assembly state: " << ix << '\n';
     cout << "masks:\n";
@@ -217,9 +233,13 @@ void assemblyState::print()
     {
         cout << "Fragment: " << i << '\n';
         bool isCyclic;
-        molGraph mg = constructFromEdgeList(targetMolecule, univEdgeList, masks[i], isCyclic);
+        molGraph mg = constructFromEdgeList<W>(targetMolecule, univEdgeList, masks[i], isCyclic);
         mg.printToCout();
     }
     cout << "AI: " << AI() << '\n';
     cout << "lowbound: " << lowBoundAI() << '\n';
 }
+
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_ASSEMBLY_STATE(W) template struct assemblyState<W>;
+FOR_EACH_MASK_WIDTH(INSTANTIATE_ASSEMBLY_STATE)
@@ -0,0 +1,421 @@
+#include "checkpoint.h"
+#include <atomic>               // for atomic
+#include <cstdint>              // for int64_t, uint64_t
+#include <cstdio>               // for rename, remove
+#include <fstream>              // for ifstream, ofstream
+#include <string>               // for string
+#include <unordered_map>        // for unordered_map
+#include <vector>               // for vector
+#include "assemblyState.h"      // for assemblyState, assemblyPath, pathPtr, minAssemblyPath
+#include "dynamicBitset.h"      // for dynamicBitset
+#include "globalPrimitives.h"   // for univEdgeList, totalBonds, minAIfound, ENUM_MAX
+#include "graphHashes.h"        // for graphHashMap, fragmentClass, fragmentSignature
+#include "maskPool.h"           // for fragmentPool, bitsetHashTable
+#include "molGraph.h"           // for targetMolecule
+#include "transpositionTable.h" // for pathAssemblyMap, diveMap
+#include "workStealingPool.h"   // for searchTask
+
+using namespace std;
+
+/// Identifies the file format, bumped whenever the layout changes
+static const char CHECKPOINT_MAGIC[8] = {'A', 'S', 'M', 'C', 'K', 'P', 'T', '7'};
+
+template <typename T>
+static void put(ofstream &out, const T &x)
+{
+    out.write(reinterpret_cast<const char *>(&x), sizeof(T));
+}
+
+template <typename T>
+static void get(ifstream &in, T &x)
+{
+    in.read(reinterpret_cast<char *>(&x), sizeof(T));
+}
+
+static void put(ofstream &out, const dynamicBitset &x)
+{
+    out.write(reinterpret_cast<const char *>(x.words.data()), x.words.size() * sizeof(uint64_t));
+}
+
+static void get(ifstream &in, dynamicBitset &x)
+{
+    in.read(reinterpret_cast<char *>(x.words.data()), x.words.size() * sizeof(uint64_t));
+}
+
+static void putString(ofstream &out, const string &s)
+{
+    put(out, uint64_t(s.size()));
+    out.write(s.data(), s.size());
+}
+
+static void getString(ifstream &in, string &s)
+{
+    uint64_t n = 0;
+    get(in, n);
+    if (!in || n > (uint64_t(1) << 20))
+    {
+        in.setstate(ios::failbit);
+        return;
+    }
+    s.resize(n);
+    in.read(&s[0], n);
+}
+
+/**
+ * @brief Writes a state, with apPtr replaced by its index in the node list, -1 for nullptr
+ */
+template <size_t W>
+static void putState(ofstream &out, assemblyState<W> &as, unordered_map<assemblyPath *, int64_t> &nodeIx)
+{
+    put(out, uint64_t(as.masks.size()));
+    for (size_t i = 0; i < as.masks.size(); i++)
+        put(out, as.masks[i]);
+    put(out, as.sumDupBonds);
+    put(out, as.ix);
+    put(out, as.apPtr == nullptr ? int64_t(-1) : nodeIx[as.apPtr.get()]);
+}
+
+template <size_t W>
+static void getState(ifstream &in, assemblyState<W> &as, vector<pathPtr> &nodes)
+{
+    uint64_t n = 0;
+    get(in, n);
+    if (!in || n > univEdgeList.size() + 1)
+    {
+        in.setstate(ios::failbit);
+        return;
+    }
+    as.masks.resize(n);
+    for (size_t i = 0; i < n; i++)
+        get(in, as.masks[i]);
+    as.describeFragments();
+    get(in, as.sumDupBonds);
+    get(in, as.ix);
+    int64_t ap = -1;
+    get(in, ap);
+    as.apPtr = (ap >= 0 && ap < int64_t(nodes.size())) ? nodes[ap] : nullptr;
+}
+
+template <size_t W>
+bool writeCheckpoint(const string &file, vector<searchTask<W>> &roots, size_t current,
+                     vector<searchFrame<W>> &stack, atomic<int> &AI)
+{
+    string tmp = file + ".tmp";
+    ofstream out(tmp.c_str(), ios::binary);
+    if (!out.is_open())
+        return false;
+    out.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    put(out, uint64_t(standardBitset<W>().size()));
+    put(out, totalBonds);
+    put(out, uint64_t(univEdgeList.size()));
+    for (size_t i = 0; i < univEdgeList.size(); i++)
+    {
+        put(out, univEdgeList[i].a);
+        put(out, univEdgeList[i].b);
+        put(out, univEdgeList[i].c);
+    }
+    // Label IDs depend on the order labels were first read in, so the atoms are stored by label
+    put(out, uint64_t(targetMolecule.mg.size()));
+    for (size_t i = 0; i < targetMolecule.mg.size(); i++)
+        putString(out, targetMolecule.atype(i));
+
+    // Canonisation tables. Masks are stored by value and interned again on reading. graphHashMap is stored as one representative mask per class and rebuilt on reading
+    put(out, uint64_t(bitsetHashTable<W>.size()));
+    for (maskId id = 0; id < bitsetHashTable<W>.idLimit(); id++)
+    {
+        pii value;
+        if (!bitsetHashTable<W>.find(id, value))
+            continue;
+        put(out, fragmentPool<W>[id]);
+        put(out, value);
+    }
+    put(out, uint64_t(graphHashMap<W>.size()));
+    for (auto it = graphHashMap<W>.buckets.begin(); it != graphHashMap<W>.buckets.end(); ++it)
+    {
+        for (const fragmentClass<W> &cls : it->second)
+        {
+            put(out, fragmentPool<W>[cls.representative]);
+            put(out, cls.value);
+        }
+    }
+
+    // Pathway nodes: both hash tables, then the nodes evicted from them that the frontier, the incumbent or another
+    // node still refers to. Parents are stored as indices into this list
+    vector<pathPtr> nodes = pathAssemblyMap.nodes(), diveNodes = diveMap.nodes();
+    size_t pathNodes = nodes.size();
+    nodes.insert(nodes.end(), diveNodes.begin(), diveNodes.end());
+    size_t tableNodes = nodes.size();
+    unordered_map<assemblyPath *, int64_t> nodeIx;
+    nodeIx.reserve(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++)
+        nodeIx[nodes[i].get()] = i;
+    auto addNode = [&nodes, &nodeIx](const pathPtr &ap)
+    {
+        if (ap != nullptr && nodeIx.count(ap.get()) == 0)
+        {
+            nodeIx[ap.get()] = nodes.size();
+            nodes.push_back(ap);
+        }
+    };
+    addNode(minAssemblyPath);
+    for (size_t i = current; i < roots.size(); i++)
+        addNode(roots[i].state.apPtr);
+    for (size_t i = 0; i < stack.size(); i++)
+        addNode(stack[i].state.apPtr);
+    for (size_t i = 0; i < nodes.size(); i++)
+        addNode(nodes[i]->parent);
+    put(out, uint64_t(nodes.size()));
+    put(out, uint64_t(pathNodes));
+    put(out, uint64_t(tableNodes));
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        assemblyPath *ap = nodes[i].get();
+        put(out, uint64_t(ap->keySize));
+        out.write(reinterpret_cast<const char *>(ap->key), ap->keySize * sizeof(int));
+        put(out, ap->sumDupBonds);
+        put(out, ap->match);
+        put(out, ap->duplicate);
+        put(out, ap->parent == nullptr ? int64_t(-1) : nodeIx[ap->parent.get()]);
+    }
+    put(out, AI.load());
+    put(out, minAIfound);
+    put(out, minAssemblyPath == nullptr ? int64_t(-1) : nodeIx[minAssemblyPath.get()]);
+
+    // Frontier: the unfinished first-level states and the stack of the current one
+    put(out, uint64_t(roots.size() - current));
+    for (size_t i = current; i < roots.size(); i++)
+    {
+        putState(out, roots[i].state, nodeIx);
+        put(out, roots[i].bound);
+    }
+    put(out, uint64_t(stack.size()));
+    for (size_t i = 0; i < stack.size(); i++)
+    {
+        searchFrame<W> &f = stack[i];
+        putState(out, f.state, nodeIx);
+        put(out, f.expanded);
+        put(out, uint64_t(f.next));
+        put(out, uint64_t(f.children.size()));
+        for (size_t j = 0; j < f.children.size(); j++)
+        {
+            rankedChild<W> &c = f.children[j];
+            put(out, c.bound);
+            put(out, c.set);
+            put(out, fragmentPool<W>[c.matching.first]);
+            put(out, fragmentPool<W>[c.matching.second]);
+            put(out, c.matching.frag1);
+            put(out, c.matching.frag2);
+            put(out, c.matching.maxFragSize);
+        }
+        put(out, uint64_t(f.sets.size()));
+        for (size_t j = 0; j < f.sets.size(); j++)
+        {
+            put(out, f.sets[j].matchMask);
+            put(out, f.sets[j].maxFragMask);
+        }
+    }
+    out.close();
+    if (!out)
+        return false;
+    remove(file.c_str());
+    return rename(tmp.c_str(), file.c_str()) == 0;
+}
+
+/**
+ * @brief Undo a partially read checkpoint
+ */
+template <size_t W>
+static void discardCheckpoint()
+{
+    bitsetHashTable<W>.clear();
+    graphHashMap<W>.clear();
+    minAssemblyPath = nullptr;
+    pathAssemblyMap.clear();
+    diveMap.clear();
+    minAIfound = -1;
+}
+
+template <size_t W>
+bool readCheckpoint(const string &file, vector<searchTask<W>> &roots, vector<searchFrame<W>> &stack, atomic<int> &AI)
+{
+    ifstream in(file.c_str(), ios::binary);
+    if (!in.is_open())
+        return false;
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || string(magic, sizeof(magic)) != string(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)))
+        return false;
+    unsigned int bonds = 0;
+    uint64_t width = 0, n = 0;
+    get(in, width);
+    get(in, bonds);
+    get(in, n);
+    if (!in || width != standardBitset<W>().size() || bonds != totalBonds || n != univEdgeList.size())
+        return false;
+    for (size_t i = 0; i < n; i++)
+    {
+        edgeL e;
+        get(in, e.a);
+        get(in, e.b);
+        get(in, e.c);
+        if (!in || e.a != univEdgeList[i].a || e.b != univEdgeList[i].b || e.c != univEdgeList[i].c)
+            return false;
+    }
+
+    get(in, n);
+    if (!in || n != targetMolecule.mg.size())
+        return false;
+    for (size_t i = 0; i < n; i++)
+    {
+        string atype;
+        getString(in, atype);
+        if (!in || atype != targetMolecule.atype(i))
+            return false;
+    }
+
+    get(in, n);
+    if (in && n <= size_t(ENUM_MAX))
+    {
+        fragmentPool<W>.reserve(fragmentPool<W>.size() + n);
+        bitsetHashTable<W>.reserve(fragmentPool<W>.size() + n);
+    }
+    for (size_t i = 0; i < n && in; i++)
+    {
+        standardBitset<W> mask;
+        pii value;
+        get(in, mask);
+        get(in, value);
+        bitsetHashTable<W>[fragmentPool<W>.intern(mask)] = value;
+    }
+    get(in, n);
+    if (in && n <= size_t(ENUM_MAX))
+    {
+        fragmentPool<W>.reserve(fragmentPool<W>.size() + n);
+        bitsetHashTable<W>.reserve(fragmentPool<W>.size() + n);
+    }
+    for (size_t i = 0; i < n && in; i++)
+    {
+        standardBitset<W> mask;
+        pii value;
+        get(in, mask);
+        get(in, value);
+        graphHashMap<W>.buckets[fragmentSignature<W>(mask)].emplace_back(fragmentPool<W>.intern(mask), value);
+        graphHashMap<W>.classes++;
+    }
+
+    uint64_t pathNodes = 0, tableNodes = 0;
+    get(in, n);
+    get(in, pathNodes);
+    get(in, tableNodes);
+    vector<pathPtr> nodes(in ? n : 0);
+    vector<int64_t> parents(nodes.size(), -1);
+    for (size_t i = 0; i < nodes.size() && in; i++)
+    {
+        uint64_t keySize = 0;
+        get(in, keySize);
+        if (!in || keySize > univEdgeList.size() + 1)
+            break;
+        vi key(keySize);
+        in.read(reinterpret_cast<char *>(key.data()), keySize * sizeof(int));
+        int sumDupBonds = 0;
+        unsigned short match = 0, duplicate = 0;
+        get(in, sumDupBonds);
+        get(in, match);
+        get(in, duplicate);
+        get(in, parents[i]);
+        if (i < tableNodes)
+        {
+            transpositionTable &table = i < pathNodes ? pathAssemblyMap : diveMap;
+            nodes[i] = table.tryClaim(key, sumDupBonds, nullptr, match, duplicate);
+        }
+        else
+        {
+            // Evicted from the tables, but still referred to
+            nodes[i] = pathAssemblyMap.makeNode(key, sumDupBonds, nullptr, match, duplicate);
+        }
+        if (nodes[i] == nullptr)
+            in.setstate(ios::failbit);
+    }
+    if (!in)
+    {
+        nodes.clear();
+        discardCheckpoint<W>();
+        return false;
+    }
+    for (size_t i = 0; i < nodes.size(); i++)
+        nodes[i]->parent = (parents[i] >= 0 && parents[i] < int64_t(nodes.size())) ? nodes[parents[i]] : nullptr;
+    int incumbent = 0;
+    int64_t incumbentPath = -1;
+    get(in, incumbent);
+    get(in, minAIfound);
+    get(in, incumbentPath);
+    AI = incumbent;
+    minAssemblyPath = (incumbentPath >= 0 && incumbentPath < int64_t(nodes.size())) ? nodes[incumbentPath] : nullptr;
+
+    get(in, n);
+    for (size_t i = 0; i < n && in; i++)
+    {
+        searchTask<W> t;
+        getState(in, t.state, nodes);
+        get(in, t.bound);
+        roots.push_back(t);
+    }
+    get(in, n);
+    for (size_t i = 0; i < n && in; i++)
+    {
+        stack.emplace_back();
+        searchFrame<W> &f = stack.back();
+        uint64_t next = 0, children = 0, sets = 0;
+        getState(in, f.state, nodes);
+        get(in, f.expanded);
+        get(in, next);
+        get(in, children);
+        f.next = next;
+        for (size_t j = 0; j < children && in; j++)
+        {
+            rankedChild<W> c;
+            standardBitset<W> first, second;
+            get(in, c.bound);
+            get(in, c.set);
+            get(in, first);
+            get(in, second);
+            c.matching.first = fragmentPool<W>.intern(first);
+            c.matching.second = fragmentPool<W>.intern(second);
+            get(in, c.matching.frag1);
+            get(in, c.matching.frag2);
+            get(in, c.matching.maxFragSize);
+            f.children.push_back(c);
+        }
+        get(in, sets);
+        for (size_t j = 0; j < sets && in; j++)
+        {
+            f.sets.emplace_back();
+            get(in, f.sets.back().matchMask);
+            get(in, f.sets.back().maxFragMask);
+        }
+        // A child that does not name one of the sets, or a next past the children, is a corrupt checkpoint
+        for (size_t j = 0; j < f.children.size(); j++)
+        {
+            if (f.children[j].set < 0 || size_t(f.children[j].set) >= f.sets.size())
+                in.setstate(ios::failbit);
+        }
+        if (f.next > f.children.size())
+            in.setstate(ios::failbit);
+    }
+    if (!in)
+    {
+        roots.clear();
+        stack.clear();
+        nodes.clear();
+        discardCheckpoint<W>();
+        return false;
+    }
+    return true;
+}
+
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_CHECKPOINT(W) \
+    template bool writeCheckpoint<W>(const string &, vector<searchTask<W>> &, size_t, vector<searchFrame<W>> &, \
+                                     atomic<int> &); \
+    template bool readCheckpoint<W>(const string &, vector<searchTask<W>> &, vector<searchFrame<W>> &, atomic<int> &);
+FOR_EACH_MASK_WIDTH(INSTANTIATE_CHECKPOINT)
@@ -1,64 +1,70 @@
 #include "dagEnumeration.h"
 #include <algorithm>          // for sort
 #include <cstddef>            // for size_t, std
+#include <cstdint>            // for uint32_t
 #include <unordered_map>      // for unordered_map, _Node_iterator, operator!=
 #include <utility>            // for pair
 #include <vector>             // for vector
-#include "globalPrimitives.h" // for standardBitset, bitsetHashTable
+#include "globalPrimitives.h" // for maskId
+#include "maskPool.h"         // for bitsetHashTable
 
 using namespace std;
 
-vector<vector<dagNode>> DAG;
-
-void convertDag(vector<std::unordered_map<standardBitset, pair<int, vector<standardBitset>>>> &tempDag)
+template <size_t W>
+void convertDag(vector<std::unordered_map<maskId, pair<int, vector<maskId>>>> &tempDag)
 {
-    DAG.resize(tempDag.size());
-    vector<std::unordered_map<standardBitset, int>> bitsetToIndex(tempDag.size());
-    for (size_t i = 0; i < tempDag.size() - 1; i++)
+    DAG<W>.assign(tempDag.size(), dagLevel());
+    // The single bonds come in the order of their bonds, so that node j of level 0 is bond j
+    vector<maskId> order;
+    order.reserve(tempDag[0].size());
+    for (auto it = tempDag[0].begin(); it != tempDag[0].end(); ++it)
+        order.push_back(it->first);
+    sort(order.begin(), order.end(), CompareDagMask<W>());
+    for (size_t i = 0; i < tempDag.size(); i++)
     {
-        for (auto it = tempDag[i].begin(); it != tempDag[i].end(); ++it)
+        dagLevel &level = DAG<W>[i];
+        bool last = i + 1 == tempDag.size();
+        // The nodes of the next level are numbered as they are first met among the children, so that the children
+        // of a node, and those of the nodes next to it, are mostly next to each other
+        std::unordered_map<maskId, uint32_t> nextIndex;
+        vector<maskId> nextOrder;
+        level.ids = order;
+        level.ix.resize(order.size(), -1);
+        level.offsets.reserve(order.size() + 1);
+        for (size_t k = 0; k < order.size(); k++)
         {
-            vector<standardBitset> &list = it->second.second;
-            size_t trueSize = list.size();
-            for (size_t j = 0; j < list.size(); j++)
-            {
-                std::unordered_map<standardBitset, pair<int, vector<standardBitset>>> &nextMap = tempDag[i + 1];
-                if (nextMap.count(list[j]) == 0)
-                {
-                    list[j] = 0;
-                    trueSize--;
-                }
-            }
-            vector<standardBitset> trueList(trueSize);
-            size_t k = 0;
-            for (size_t j = 0; j < list.size(); j++)
+            // The single bonds are never looked up by their canonical index
+            if (i > 0)
+                level.ix[k] = bitsetHashTable<W>[order[k]].first;
+            if (!last)
             {
-                if (list[j] != 0)
+                // Children that did not make it into the next level are dropped
+                vector<maskId> &list = tempDag[i][order[k]].second;
+                for (size_t j = 0; j < list.size(); j++)
                 {
-                    trueList[k] = list[j];
-                    k++;
+                    if (tempDag[i + 1].count(list[j]) == 0)
+                        continue;
+                    auto found = nextIndex.try_emplace(list[j], uint32_t(nextOrder.size()));
+                    if (found.second)
+                        nextOrder.push_back(list[j]);
+                    level.children.push_back(found.first->second);
                 }
             }
-            it->second.second = trueList;
-            if (i > 0)
-            {
-                it->second.first = bitsetHashTable[it->first].first;
-                size_t x = bitsetToIndex[i].size();
-                bitsetToIndex[i][it->first] = x;
-            }
+            level.offsets.push_back(level.children.size());
         }
-    }
-    for (auto it = tempDag[tempDag.size() - 1].begin(); it != tempDag[tempDag.size() - 1].end(); ++it)
-    {
-        it->second.first = bitsetHashTable[it->first].first;
-    }
-    for (size_t i = 0; i < DAG.size() - 1; i++)
-    {
-        for (auto it = tempDag[i].begin(); it != tempDag[i].end(); ++it)
+        if (last)
+            break;
+        // Every node was generated from one of the level below, but number any other all the same
+        for (auto it = tempDag[i + 1].begin(); it != tempDag[i + 1].end(); ++it)
         {
-            dagNode dn(it->first, it->second.first, it->second.second, bitsetToIndex[i + 1]);
-            DAG[i].push_back(dn);
+            if (nextIndex.try_emplace(it->first, uint32_t(nextOrder.size())).second)
+                nextOrder.push_back(it->first);
         }
+        order.swap(nextOrder);
     }
-    sort(DAG[0].begin(), DAG[0].end(), CompareDagNode());
 }
+
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_DAG_ENUMERATION(W) \
+    template void convertDag<W>(vector<std::unordered_map<maskId, pair<int, vector<maskId>>>> &);
+FOR_EACH_MASK_WIDTH(INSTANTIATE_DAG_ENUMERATION)
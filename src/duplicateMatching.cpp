@@ -6,39 +6,49 @@
 #include <unordered_set>      // for unordered_set
 #include <utility>            // for pair
 #include <vector>             // for vector
-#include "dagEnumeration.h"   // for dagNode, DAG
+#include "dagEnumeration.h"   // for dagLevel, DAG
 #include "globalPrimitives.h" // for standardBitset, triple, univEdgeList
+#include "graphHashes.h"      // for extendSignature
+#include "maskKernels.h"      // for isSubset, isDisjoint, orInto
+#include "maskPool.h"         // for fragmentPool, maskId
 
 using namespace std;
 
-initialPotentialDuplicate::initialPotentialDuplicate(int x, standardBitset &_fragMask, size_t _fragment)
+template <size_t W>
+initialPotentialDuplicate<W>::initialPotentialDuplicate(int x, standardBitset<W> &_fragMask, size_t _fragment)
 {
     fragMask = _fragMask;
     fragment = _fragment;
+    standardBitset<W> mask = 0;
+    signature = extendSignature<W>(0, mask, x);
     mask.set(x);
+    id = fragmentPool<W>.intern(mask);
     atomMask.set(univEdgeList[x].a);
     atomMask.set(univEdgeList[x].b);
 }
 
-void initialPotentialDuplicate::generate(vector<initialPotentialDuplicate> &q, size_t fragment, std::unordered_set<standardBitset> &maskMap)
+template <size_t W>
+void initialPotentialDuplicate<W>::generate(vector<initialPotentialDuplicate> &q, size_t fragment, std::unordered_set<maskId> &maskMap)
 {
     vector<edgeL> &edgeList = univEdgeList;
+    const standardBitset<W> &mask = fragmentPool<W>[id];
     for (size_t i = 0; i < edgeList.size(); i++)
     {
         if ((mask[i] == 0) && (fragMask[i] != 0))
         {
-            standardBitset temp1 = 0, temp2 = 0;
+            standardBitset<W> temp1 = 0, temp2 = 0;
             temp1.set(edgeList[i].a);
             temp2.set(edgeList[i].b);
             if ((temp1 & atomMask) == temp1 || (temp2 & atomMask) == temp2)
             {
-                standardBitset tempMask = mask;
+                standardBitset<W> tempMask = mask;
                 tempMask.set(i);
-                if (maskMap.count(tempMask) == 0)
+                maskId tempId = fragmentPool<W>.intern(tempMask);
+                if (maskMap.insert(tempId).second)
                 {
-                    maskMap.insert(tempMask);
                     initialPotentialDuplicate g = *this;
-                    g.mask.set(i);
+                    g.id = tempId;
+                    g.signature = extendSignature<W>(signature, mask, i);
                     g.atomMask |= (temp1 | temp2);
                     q.push_back(g);
                 }
@@ -47,59 +57,68 @@ void initialPotentialDuplicate::generate(vector<initialPotentialDuplicate> &q, s
     }
 }
 
-void initialPotentialDuplicate::generateDAG(vector<initialPotentialDuplicate> &q, size_t fragment, std::unordered_set<standardBitset> &maskMap,
-                                            vector<std::unordered_map<standardBitset, pair<int, vector<standardBitset>>>> &tempDag)
+template <size_t W>
+void initialPotentialDuplicate<W>::generateDAG(vector<initialPotentialDuplicate> &q, size_t fragment, std::unordered_set<maskId> &maskMap,
+                                               vector<std::unordered_map<maskId, pair<int, vector<maskId>>>> &tempDag)
 {
     vector<edgeL> &edgeList = univEdgeList;
+    // The pool never moves its masks, so the reference survives the interning below
+    const standardBitset<W> &mask = fragmentPool<W>[id];
+    size_t size = mask.count();
     for (size_t i = 0; i < edgeList.size(); i++)
     {
         if ((mask[i] == 0) && (fragMask[i] != 0))
         {
-            standardBitset temp1, temp2;
+            standardBitset<W> temp1, temp2;
             temp1.set(edgeList[i].a),
                 temp2.set(edgeList[i].b);
             if ((temp1 & atomMask) == temp1 || (temp2 & atomMask) == temp2)
             {
-                standardBitset tempMask = mask;
+                standardBitset<W> tempMask = mask;
                 tempMask.set(i);
-                if (maskMap.count(tempMask) == 0)
+                maskId tempId = fragmentPool<W>.intern(tempMask);
+                if (maskMap.insert(tempId).second)
                 {
-                    maskMap.insert(tempMask);
                     initialPotentialDuplicate g = *this;
-                    g.mask.set(i);
+                    g.id = tempId;
+                    g.signature = extendSignature<W>(signature, mask, i);
                     g.atomMask |= (temp1 | temp2);
                     q.push_back(g);
-                    vector<standardBitset> &adjList = tempDag[mask.count() - 1][mask].second;
-                    pair<int, vector<standardBitset>> p;
-                    tempDag[mask.count()][g.mask] = p;
-                    adjList.push_back(g.mask);
+                    vector<maskId> &adjList = tempDag[size - 1][id].second;
+                    pair<int, vector<maskId>> p;
+                    tempDag[size][tempId] = p;
+                    adjList.push_back(tempId);
                 }
             }
         }
     }
 }
 
-bool dagGenerate(potentialDuplicate &d, map<int, dagDuplicateSet> &stmap, standardBitset &fragment,
+template <size_t W>
+bool dagGenerate(potentialDuplicate<W> &d, map<int, dagDuplicateSet<W>> &stmap, standardBitset<W> &fragment,
                  size_t size, int ordinal, size_t frags)
 {
     bool overweight = 0;
-    for (size_t i = 0; i < DAG[size - 1][d.idx].children.size(); i++)
+    const dagLevel &parents = DAG<W>[size - 1], &level = DAG<W>[size];
+    for (uint32_t k = parents.offsets[d.idx]; k < parents.offsets[d.idx + 1]; k++)
     {
-        dagNode &dn = DAG[size][DAG[size - 1][d.idx].children[i]];
-        if (((dn.mask | fragment) == fragment))
+        uint32_t child = parents.children[k];
+        maskId id = level.ids[child];
+        if (isSubset(fragmentPool<W>[id], fragment))
         {
-            if (dn.ix <= ordinal)
+            int ix = level.ix[child];
+            if (ix <= ordinal)
             {
-                auto it = stmap.find(dn.ix);
+                auto it = stmap.find(ix);
                 if (it == stmap.end())
                 {
-                    dagDuplicateSet ss(size + 1, frags);
-                    ss.insert(potentialDuplicate(dn.mask, d.fragment, DAG[size - 1][d.idx].children[i]));
-                    stmap[dn.ix] = ss;
+                    dagDuplicateSet<W> ss(size + 1, frags);
+                    ss.insert(potentialDuplicate<W>(id, d.fragment, child));
+                    stmap[ix] = ss;
                 }
                 else
                 {
-                    it->second.insert(potentialDuplicate(dn.mask, d.fragment, DAG[size - 1][d.idx].children[i]));
+                    it->second.insert(potentialDuplicate<W>(id, d.fragment, child));
                 }
             }
             else
@@ -109,8 +128,9 @@ bool dagGenerate(potentialDuplicate &d, map<int, dagDuplicateSet> &stmap, standa
     return overweight;
 }
 
-bool dagDuplicateGenerator(dagDuplicateSet &ds, map<int, dagDuplicateSet> &stmap,
-                           vector<standardBitset> &takenMasks, vector<standardBitset> &stateMasks, int ordinal, bool &overweight, bool last)
+template <size_t W>
+bool dagDuplicateGenerator(dagDuplicateSet<W> &ds, map<int, dagDuplicateSet<W>> &stmap,
+                           vector<standardBitset<W>> &takenMasks, vector<standardBitset<W>> &stateMasks, int ordinal, bool &overweight, bool last)
 {
     bool output = 0;
     vb alive(ds.list.size(), 0);
@@ -123,7 +143,7 @@ bool dagDuplicateGenerator(dagDuplicateSet &ds, map<int, dagDuplicateSet> &stmap
             {
                 if (frag == ds.list[j].fragment)
                 {
-                    if ((ds.list[i].mask & ds.list[j].mask) == 0)
+                    if (isDisjoint(fragmentPool<W>[ds.list[i].id], fragmentPool<W>[ds.list[j].id]))
                     {
                         alive[i] = 1;
                         alive[j] = 1;
@@ -140,7 +160,7 @@ bool dagDuplicateGenerator(dagDuplicateSet &ds, map<int, dagDuplicateSet> &stmap
             alive[i] = 1;
         if (alive[i])
         {
-            takenMasks[frag] |= ds.list[i].mask;
+            orInto(takenMasks[frag], fragmentPool<W>[ds.list[i].id]);
             ds.dead = 0;
             if (!last)
             {
@@ -151,4 +171,13 @@ bool dagDuplicateGenerator(dagDuplicateSet &ds, map<int, dagDuplicateSet> &stmap
         }
     }
     return output;
-}
\ No newline at end of file
+}
+
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_DUPLICATE_MATCHING(W) \
+    template struct initialPotentialDuplicate<W>; \
+    template bool dagGenerate<W>(potentialDuplicate<W> &, map<int, dagDuplicateSet<W>> &, standardBitset<W> &, \
+                                 size_t, int, size_t); \
+    template bool dagDuplicateGenerator<W>(dagDuplicateSet<W> &, map<int, dagDuplicateSet<W>> &, \
+                                           vector<standardBitset<W>> &, vector<standardBitset<W>> &, int, bool &, bool);
+FOR_EACH_MASK_WIDTH(INSTANTIATE_DUPLICATE_MATCHING)
@@ -2,71 +2,85 @@
 #include <bitset>              // for bitset
 #include <cstddef>             // for size_t, std
 #include <unordered_map>       // for unordered_map
-#include <unordered_set>       // for unordered_set, operator!=, _Node_iter...
 #include <vector>              // for vector
-#include "assemblyState.h"     // for assemblyState, apWrapper, pathAssembl...
+#include "assemblyState.h"     // for assemblyState, minAssemblyPath
 #include "duplicateMatching.h" // for validMatchings
-#include "globalPrimitives.h"  // for standardBitset, bitsetHashTable
+#include "globalPrimitives.h"  // for standardBitset
 #include "graphHashes.h"       // for canonise
+#include "maskPool.h"          // for fragmentPool
 #include "molGraph.h"          // for ufdsMaskConstruct
+#include "transpositionTable.h" // for pathAssemblyMap, diveMap
 
 using namespace std;
 
-void fragmentAssemblyState(assemblyState &_target, validMatchings &matching,
-                           assemblyState &_result)
+template <size_t W>
+void fragmentAssemblyState(assemblyState<W> &_target, validMatchings<W> &matching,
+                           assemblyState<W> &_result)
 {
-    vector<standardBitset> &masks = _target.masks;
-    standardBitset f1 = matching.first, f2 = matching.second;
+    vector<standardBitset<W>> &masks = _target.masks;
+    standardBitset<W> f1 = fragmentPool<W>[matching.first], f2 = fragmentPool<W>[matching.second];
     bool same = 1;
     if (matching.frag1 != matching.frag2)
         same = 0;
     _result.masks.push_back(f1);
     if (same)
     {
-        standardBitset resultMask = masks[matching.frag1];
+        standardBitset<W> resultMask = masks[matching.frag1];
         resultMask ^= f1;
         resultMask ^= f2;
-        ufdsMaskConstruct(resultMask, _result.masks);
+        ufdsMaskConstruct<W>(resultMask, _result.masks);
     }
     else
     {
-        standardBitset resultMask1 = masks[matching.frag1];
+        standardBitset<W> resultMask1 = masks[matching.frag1];
         resultMask1 ^= f1;
-        ufdsMaskConstruct(resultMask1, _result.masks);
-        standardBitset resultMask2 = masks[matching.frag2];
+        ufdsMaskConstruct<W>(resultMask1, _result.masks);
+        standardBitset<W> resultMask2 = masks[matching.frag2];
         resultMask2 ^= f2;
-        ufdsMaskConstruct(resultMask2, _result.masks);
+        ufdsMaskConstruct<W>(resultMask2, _result.masks);
     }
+    // The key sum of the result is that of the target less the fragments that are split or dropped, plus the new
+    // ones, so fragments carried over unchanged cost nothing
+    _result.idSum = _target.idSum - stateKey::idKey(_target.frags[matching.frag1].canon);
+    if (!same)
+        _result.idSum -= stateKey::idKey(_target.frags[matching.frag2].canon);
+    // The descriptors of the new fragments are filled here, where they are canonised anyway
     for (size_t i = 0; i < _result.masks.size(); i++)
     {
-        canonise(_result.masks[i]);
+        int canon = canonise<W>(_result.masks[i]);
+        _result.frags.push_back({int(_result.masks[i].count()), canon});
+        _result.idSum += stateKey::idKey(canon);
     }
     for (size_t i = 0; i < masks.size(); i++)
     {
-        if (i != matching.frag1 && i != matching.frag2 && masks[i] != 0)
+        if (i == matching.frag1 || i == matching.frag2)
+            continue;
+        if (masks[i] != 0 && _target.frags[i].canon >= 0)
         {
-            vector<standardBitset> tempMasks;
-            if (bitsetHashTable.count(masks[i]) == 0)
-            {
-                ufdsMaskConstruct(masks[i], tempMasks);
-                for (size_t j = 0; j < tempMasks.size(); j++)
-                {
-                    canonise(tempMasks[j]);
-                    _result.masks.push_back(tempMasks[j]);
-                }
-            }
-            else
-                _result.masks.push_back(masks[i]);
+            _result.masks.push_back(masks[i]);
+            _result.frags.push_back(_target.frags[i]);
+            continue;
         }
+        // Emptied fragments are dropped, and those trimmed since they were canonised are split into their pieces
+        _result.idSum -= stateKey::idKey(_target.frags[i].canon);
+        if (masks[i] == 0)
+            continue;
+        vector<standardBitset<W>> tempMasks;
+        ufdsMaskConstruct<W>(masks[i], tempMasks);
+        for (size_t j = 0; j < tempMasks.size(); j++)
+            _result.addFragment(tempMasks[j], canonise<W>(tempMasks[j]));
     }
 }
 
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_FRAGMENTATION(W) \
+    template void fragmentAssemblyState<W>(assemblyState<W> &, validMatchings<W> &, assemblyState<W> &);
+FOR_EACH_MASK_WIDTH(INSTANTIATE_FRAGMENTATION)
+
 void clearPathMap()
 {
-    vector<std::unordered_set<assemblyPath *>::iterator> vit;
-    for (auto it = pathAssemblyMap.begin(); it != pathAssemblyMap.end(); ++it)
-    {
-        delete (*it).ap;
-    }
+    // The incumbent pathway is the only reference to the nodes kept between searches
+    minAssemblyPath = nullptr;
     pathAssemblyMap.clear();
+    diveMap.clear();
 }
\ No newline at end of file
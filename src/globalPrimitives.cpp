@@ -3,18 +3,36 @@
 #include "globalPrimitives.h"
 int DISCHARGE_FREQUENCY = 30000000, ENUM_MAX = 50000000;
 int minAIfound = -1;
-int recursiveCount = 1;
-int assemblyIx = 0;
+int aiOffset = 0;
+std::atomic<int> recursiveCount(1);
+std::atomic<int> assemblyIx(0);
+int numThreads = 1;
+bool bestFirst = 0;
+size_t frontierMax = 1000000;
+bool branchOrder = 0;
+size_t sliceNodes = 0;
+std::string checkpointFile, resumeFile;
+unsigned long long checkpointTime = 600ULL * CLOCKS_PER_SEC;
+size_t checkpointNodes = 0;
+size_t ttMemory = 0;
+size_t diveBeam = 0;
+int threshold = -1;
 
-std::unordered_map<std::string, int> atypeHash;
 std::vector<double> coords;
 std::string moleculeName;
-standardBitset allEdges;
-volatile bool interruptFlag = false;
+size_t maskWidth = BITSET_LENGTH;
+std::atomic<bool> interruptFlag(false);
 clock_t startTime = 0;
 unsigned long long runTimeMax = ULLONG_MAX;
 unsigned int totalBonds = 0;
 std::vector<edgeL> removedEdges;
 std::vector<edgeL> originalEdgeList, univEdgeList;
-std::unordered_map<standardBitset, pii> bitsetHashTable;
-bool isPathway = 1, removeHydrogens = 1, disjointCompensation = 0;
\ No newline at end of file
+bool isPathway = 1, removeHydrogens = 1, disjointCompensation = 0;
+
+size_t selectMaskWidth(size_t bonds, size_t atoms)
+{
+    size_t width = 64;
+    while (width <= BITSET_LENGTH && (bonds >= width || atoms > width))
+        width <<= 1;
+    return width <= BITSET_LENGTH ? width : DYNAMIC_WIDTH;
+}
@@ -0,0 +1,245 @@
+#include "graphCanon.h"
+#include <algorithm>          // for sort, max, equal, lexicographical_compare
+#include <cstdint>            // for uint32_t
+#include <numeric>            // for iota
+#include <string>             // for string
+#include <utility>            // for move
+#include <vector>             // for vector
+#include "globalPrimitives.h" // for vi
+#include "molGraph.h"         // for labelledGraph
+
+using namespace std;
+
+/// Automorphisms kept for pruning. Past this many the search stays exact but prunes less
+constexpr size_t MAX_AUTOMORPHISMS = 64;
+
+/**
+ * @brief Search for the smallest certificate of one graph. A colouring gives each vertex the position of the first
+ * vertex of its cell in the ordered partition, so colours are the same for isomorphic graphs
+ */
+struct canonSearch
+{
+    const labelledGraph &g;
+    /// @brief vertices individualised on the way from the root to the current node
+    vi prefix;
+    /// @brief certificates and labellings of the first leaf and of the smallest leaf so far
+    std::string first, best;
+    vi firstLab, bestLab;
+    /// @brief automorphisms found from leaves with equal certificates
+    std::vector<vi> automorphisms;
+    /// @brief scratch space of refine. After refine, order lists the vertices by colour
+    vi order, cursor;
+    /// @brief neighbour colours and bond types of each vertex, sorted, laid out like nbr
+    std::vector<uint32_t> sig;
+    /// @brief scratch space of certificate: the vertex with each label, and one row of the encoding
+    vi at;
+    std::vector<uint32_t> row;
+
+    canonSearch(const labelledGraph &_g) : g(_g), order(_g.n), cursor(_g.n), sig(_g.nbr.size()), at(_g.n) {}
+
+    /**
+     * @brief Split cells until every vertex of a cell sees the same colours through the same bond types
+     */
+    void refine(vi &colour)
+    {
+        int n = g.n;
+        for (int c = 0; c < n; c++)
+            cursor[c] = c;
+        for (int v = 0; v < n; v++)
+            order[cursor[colour[v]]++] = v;
+        bool split = true;
+        while (split)
+        {
+            split = false;
+            for (int s = 0, e; s < n; s = e)
+            {
+                e = s + 1;
+                while (e < n && colour[order[e]] == s)
+                    e++;
+                if (e - s == 1)
+                    continue;
+                for (int i = s; i < e; i++)
+                {
+                    int v = order[i];
+                    for (int k = g.start[v]; k < g.start[v + 1]; k++)
+                        sig[k] = uint32_t(colour[g.nbr[k]]) << 8 | uint32_t(g.btype[k] & 0xff);
+                    sort(sig.begin() + g.start[v], sig.begin() + g.start[v + 1]);
+                }
+                sort(order.begin() + s, order.begin() + e, [this](int a, int b)
+                     { return lexicographical_compare(sig.begin() + g.start[a], sig.begin() + g.start[a + 1],
+                                                      sig.begin() + g.start[b], sig.begin() + g.start[b + 1]); });
+                for (int i = s + 1, c = s; i < e; i++)
+                {
+                    int a = order[i - 1], b = order[i];
+                    if (!equal(sig.begin() + g.start[a], sig.begin() + g.start[a + 1],
+                               sig.begin() + g.start[b], sig.begin() + g.start[b + 1]))
+                    {
+                        c = i;
+                        split = true;
+                    }
+                    colour[order[i]] = c;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Encoding of the graph with each vertex labelled by its colour in a discrete colouring: the atom types
+     * in label order, then for each label the labels and bond types of its neighbours with larger labels
+     */
+    std::string certificate(const vi &colour)
+    {
+        int n = g.n, maxValue = n;
+        for (int v = 0; v < n; v++)
+            maxValue = max(maxValue, g.type[v]);
+        int width = maxValue < 0x10000 ? 2 : 4;
+        std::string out(1, char(width));
+        out.reserve(1 + width * (1 + 2 * n + g.nbr.size()));
+        auto put = [&out, width](uint32_t x)
+        {
+            for (int b = 0; b < width; b++)
+                out.push_back(char(x >> (8 * b)));
+        };
+        put(n);
+        for (int v = 0; v < n; v++)
+            at[colour[v]] = v;
+        for (int i = 0; i < n; i++)
+            put(g.type[at[i]]);
+        for (int i = 0; i < n; i++)
+        {
+            int v = at[i];
+            row.clear();
+            for (int k = g.start[v]; k < g.start[v + 1]; k++)
+            {
+                if (colour[g.nbr[k]] > i)
+                    row.push_back(uint32_t(colour[g.nbr[k]]) << 8 | uint32_t(g.btype[k] & 0xff));
+            }
+            sort(row.begin(), row.end());
+            put(row.size());
+            for (uint32_t x : row)
+            {
+                put(x >> 8);
+                put(x & 0xff);
+            }
+        }
+        return out;
+    }
+
+    void leaf(const vi &colour)
+    {
+        std::string cert = certificate(colour);
+        if (firstLab.empty())
+        {
+            first = best = cert;
+            firstLab = bestLab = colour;
+            return;
+        }
+        const vi *same = cert == first ? &firstLab : cert == best ? &bestLab : nullptr;
+        if (same != nullptr)
+        {
+            // Both labellings give the same graph, so labelling with one and going back with the other is an
+            // automorphism
+            if (automorphisms.size() < MAX_AUTOMORPHISMS)
+            {
+                vi gamma(g.n);
+                for (int v = 0; v < g.n; v++)
+                    at[(*same)[v]] = v;
+                for (int v = 0; v < g.n; v++)
+                    gamma[v] = at[colour[v]];
+                automorphisms.push_back(move(gamma));
+            }
+            return;
+        }
+        if (cert < best)
+        {
+            best = move(cert);
+            bestLab = colour;
+        }
+    }
+
+    /**
+     * @brief Whether individualising w leads to the same leaves as a vertex already explored, as an automorphism
+     * fixing the prefix maps one onto the other
+     */
+    bool pruned(int w, const vi &explored) const
+    {
+        if (explored.empty() || automorphisms.empty())
+            return false;
+        vi root(g.n);
+        iota(root.begin(), root.end(), 0);
+        auto find = [&root](int v)
+        {
+            while (root[v] != v)
+                v = root[v] = root[root[v]];
+            return v;
+        };
+        for (const vi &gamma : automorphisms)
+        {
+            bool fixes = true;
+            for (int p : prefix)
+                fixes &= gamma[p] == p;
+            if (!fixes)
+                continue;
+            for (int v = 0; v < g.n; v++)
+                root[find(v)] = find(gamma[v]);
+        }
+        for (int v : explored)
+        {
+            if (find(v) == find(w))
+                return true;
+        }
+        return false;
+    }
+
+    void search(vi colour)
+    {
+        refine(colour);
+        // Branch on the first cell with more than one vertex
+        vi cell;
+        for (int s = 0, e; s < g.n && cell.empty(); s = e)
+        {
+            e = s + 1;
+            while (e < g.n && colour[order[e]] == s)
+                e++;
+            if (e - s > 1)
+                cell.assign(order.begin() + s, order.begin() + e);
+        }
+        if (cell.empty())
+        {
+            leaf(colour);
+            return;
+        }
+        int s = colour[cell[0]];
+        vi explored;
+        for (int w : cell)
+        {
+            if (pruned(w, explored))
+                continue;
+            // w keeps the start of the cell and the rest of the cell follows it
+            vi child = colour;
+            for (int v : cell)
+            {
+                if (v != w)
+                    child[v] = s + 1;
+            }
+            prefix.push_back(w);
+            search(move(child));
+            prefix.pop_back();
+            explored.push_back(w);
+        }
+    }
+};
+
+string canonicalCertificate(const labelledGraph &g)
+{
+    // The initial colouring is by atom type
+    vi byType(g.n), colour(g.n);
+    iota(byType.begin(), byType.end(), 0);
+    sort(byType.begin(), byType.end(), [&g](int a, int b)
+         { return g.type[a] < g.type[b]; });
+    for (int i = 0; i < g.n; i++)
+        colour[byType[i]] = i > 0 && g.type[byType[i]] == g.type[byType[i - 1]] ? colour[byType[i - 1]] : i;
+    canonSearch cs(g);
+    cs.search(move(colour));
+    return cs.best;
+}
@@ -1,93 +1,289 @@
 #include "graphHashes.h"
-#include <algorithm>          // for min
+#include <algorithm>          // for sort, unique
 #include <bitset>             // for hash
+#include <cstdint>            // for uint64_t
+#include <mutex>              // for unique_lock, shared_lock
+#include <optional>           // for optional
+#include <shared_mutex>       // for shared_mutex
 #include <string>             // for basic_string, operator==, hash, string
 #include <unordered_map>      // for unordered_map
-#include <utility>            // for pair
+#include <utility>            // for pair, move
 #include <vector>             // for vector
-#include "globalPrimitives.h" // for atypeHash, bitsetHashTable, standardBi...
-#include "molGraph.h"         // for molGraph, atom, constructFromEdgeList
-#include "treeCanon.h"        // for centroidTreeCanon
+#include "globalPrimitives.h" // for standardBitset, univEdgeList, vi
+#include "graphCanon.h"       // for canonicalCertificate
+#include "maskPool.h"         // for fragmentPool, bitsetHashTable
+#include "molGraph.h"         // for labelledGraph, targetMolecule, toLabelledGraph
+#include "treeCanon.h"        // for treeCanonKey
+#include "vf2.h"              // for vf2GraphIso
 
 using namespace std;
 
-graphHash::graphHash(molGraph &mg, int depth, bool isCyclic, standardBitset &_mask)
+/**
+ * @brief Whether the bonds set in mask close a ring
+ */
+template <size_t W>
+static bool hasRing(const standardBitset<W> &mask)
 {
-    mask = _mask;
-    if (isCyclic)
+    vi root(targetMolecule.mg.size());
+    for (size_t i = 0; i < root.size(); i++)
+        root[i] = i;
+    auto find = [&root](int v)
     {
-        hashes.resize(mg.mg.size(), 0);
-        calcHash(mg, depth);
+        while (root[v] != v)
+            v = root[v] = root[root[v]];
+        return v;
+    };
+    for (size_t i = 0; i < univEdgeList.size(); i++)
+    {
+        if (!mask[i])
+            continue;
+        int a = find(univEdgeList[i].a), b = find(univEdgeList[i].b);
+        if (a == b)
+            return true;
+        root[a] = b;
     }
+    return false;
+}
+
+template <size_t W>
+graphHash<W>::graphHash(const standardBitset<W> &_mask) : mask(_mask)
+{
+    labelledGraph g = toLabelledGraph<W>(targetMolecule, univEdgeList, mask);
+    if (hasRing<W>(mask))
+        certificate = canonicalCertificate(g);
     else
-        treeHash = centroidTreeCanon(mg, 0);
+        treeKey = treeCanonKey(g);
+}
+
+/// splitmix64 finaliser
+static uint64_t mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
 }
 
-void graphHash::calcHash(molGraph &mg, int _depth)
+/// Key of the type of each atom of targetMolecule
+static vector<uint64_t> atomKey;
+/// The bonds of atom v are incidentEdge[incidentStart[v]] to incidentEdge[incidentStart[v + 1] - 1], to the atoms
+/// incidentAtom with bond types incidentType
+static vi incidentStart, incidentEdge, incidentAtom, incidentType;
+
+void prepareFragmentSignatures()
 {
-    const double depthFactor = 0.33;
-    int depth = min(_depth, HASH_DEPTH_MAX);
-    vector<double> dhashes(hashes.size(), 0.0);
-    for (size_t i = 0; i < mg.mg.size(); i++)
+    size_t atoms = targetMolecule.mg.size();
+    atomKey.resize(atoms);
+    for (size_t v = 0; v < atoms; v++)
+        atomKey[v] = mix(targetMolecule.mg[v].type);
+    incidentStart.assign(atoms + 1, 0);
+    for (const edgeL &e : univEdgeList)
     {
-        string atype1 = mg.mg[i].type;
-        if (atypeHash.count(atype1) == 0)
-            atypeHash[atype1] = (atypeHash.size() + 1) * 5;
-        dhashes[i] = (0.0 + atypeHash[atype1]) / depthFactor;
-        for (size_t j = 0; j < mg.degree(i); j++)
-        {
-            short btype = mg.btype(i, j);
-            string atype = mg.atype(mg.elem(i, j));
-            if (atypeHash.count(atype) == 0)
-                atypeHash[atype] = (atypeHash.size() + 1) * 5;
-            int atypeInt = atypeHash[atype];
-            dhashes[i] += atypeInt + btype;
-        }
+        incidentStart[e.a + 1]++;
+        incidentStart[e.b + 1]++;
     }
-    for (int k = 1; k < depth; k++)
+    for (size_t v = 0; v < atoms; v++)
+        incidentStart[v + 1] += incidentStart[v];
+    incidentEdge.resize(2 * univEdgeList.size());
+    incidentAtom.resize(2 * univEdgeList.size());
+    incidentType.resize(2 * univEdgeList.size());
+    vi next(incidentStart.begin(), incidentStart.end() - 1);
+    for (size_t i = 0; i < univEdgeList.size(); i++)
     {
-        vector<double> oldHashes = dhashes;
-        for (size_t i = 0; i < mg.mg.size(); i++)
+        const edgeL &e = univEdgeList[i];
+        int btype = targetMolecule.btypeS(e.a, e.c);
+        for (int k : {next[e.a]++, next[e.b]++})
         {
-            for (size_t j = 0; j < mg.degree(i); j++)
-            {
-                short btype = mg.btype(i, j);
-                dhashes[i] += (oldHashes[mg.elem(i, j)] + btype) * k * depthFactor;
-            }
+            incidentEdge[k] = i;
+            incidentType[k] = btype;
         }
+        incidentAtom[next[e.a] - 1] = e.b;
+        incidentAtom[next[e.b] - 1] = e.a;
     }
-    for (size_t i = 0; i < hashes.size(); i++)
-        hashes[i] = (float)dhashes[i];
 }
 
-std::unordered_map<graphHash, pii> graphHashMap;
-
-int canonise(standardBitset &mask)
+/**
+ * @brief The subgraph of the signature functions: the bonds set in mask, and the bond extra if it is not -1
+ */
+template <size_t W>
+struct signatureSubgraph
 {
-    bool isCyclic;
-    vector<edgeL> &edgeList = univEdgeList;
-    size_t x;
-    if (bitsetHashTable.count(mask) == 0)
+    const standardBitset<W> &mask;
+    int extra;
+
+    bool has(int k) const { return incidentEdge[k] == extra || mask[incidentEdge[k]]; }
+
+    /// @brief colour of atom v after one round of refinement, 0 if it has no bonds in the subgraph
+    uint64_t colour(int v) const
     {
-        molGraph mg = constructFromEdgeList(targetMolecule, edgeList, mask, isCyclic);
-        graphHash g(mg, mg.mg.size(), isCyclic, mask);
-        if (graphHashMap.count(g) == 0)
+        uint64_t bonds = 0;
+        for (int k = incidentStart[v]; k < incidentStart[v + 1]; k++)
         {
-            x = graphHashMap.size();
-            graphHashMap[g].first = x;
-            graphHashMap[g].second = 1;
+            if (has(k))
+                bonds += mix(atomKey[incidentAtom[k]] + incidentType[k]);
         }
-        else
+        return bonds == 0 ? 0 : mix(atomKey[v] ^ bonds);
+    }
+
+    /// @brief term of atom v in the signature: its colour after a second round of refinement
+    uint64_t term(int v) const
+    {
+        uint64_t own = colour(v), bonds = 0;
+        if (own == 0)
+            return 0;
+        for (int k = incidentStart[v]; k < incidentStart[v + 1]; k++)
         {
-            x = graphHashMap[g].first;
-            graphHashMap[g].second++;
+            if (has(k))
+                bonds += mix(colour(incidentAtom[k]) + incidentType[k]);
         }
-        bitsetHashTable[mask].first = x;
-        bitsetHashTable[mask].second = graphHashMap[g].second;
+        return mix(own ^ bonds);
     }
-    else
+};
+
+template <size_t W>
+uint64_t fragmentSignature(const standardBitset<W> &mask)
+{
+    signatureSubgraph<W> subgraph{mask, -1};
+    uint64_t signature = 0;
+    for (size_t v = 0; v + 1 < incidentStart.size(); v++)
+        signature += subgraph.term(v);
+    return signature;
+}
+
+template <size_t W>
+uint64_t extendSignature(uint64_t signature, const standardBitset<W> &mask, size_t edge)
+{
+    signatureSubgraph<W> before{mask, -1}, after{mask, int(edge)};
+    // The bond changes the first-round colours of its atoms, and so the terms of those atoms and their neighbours
+    vi changed;
+    for (int v : {univEdgeList[edge].a, univEdgeList[edge].b})
+    {
+        changed.push_back(v);
+        for (int k = incidentStart[v]; k < incidentStart[v + 1]; k++)
+        {
+            if (after.has(k))
+                changed.push_back(incidentAtom[k]);
+        }
+    }
+    sort(changed.begin(), changed.end());
+    changed.erase(unique(changed.begin(), changed.end()), changed.end());
+    for (int v : changed)
+        signature += after.term(v) - before.term(v);
+    return signature;
+}
+
+std::shared_mutex canonMutex;
+
+template <size_t W>
+bool findCanonical(maskId id, pii &result)
+{
+    shared_lock<shared_mutex> lock(canonMutex);
+    return bitsetHashTable<W>.find(id, result);
+}
+
+template <size_t W>
+bool findCanonical(const standardBitset<W> &mask, pii &result)
+{
+    shared_lock<shared_mutex> lock(canonMutex);
+    maskId id;
+    return fragmentPool<W>.find(mask, id) && bitsetHashTable<W>.find(id, result);
+}
+
+/**
+ * @brief The class of the pooled mask with ID id among the classes with its signature, or nullptr if it is in none
+ * of them. The canonical form of the mask is computed, and left in hash, only if there is more than one class to
+ * choose from
+ */
+template <size_t W>
+static fragmentClass<W> *matchClass(vector<fragmentClass<W>> &bucket, maskId id, optional<graphHash<W>> &hash)
+{
+    if (bucket.empty())
+        return nullptr;
+    const standardBitset<W> &mask = fragmentPool<W>[id];
+    if (bucket.size() == 1 && !bucket[0].hash)
+    {
+        // Against a single class one isomorphism test settles it
+        const standardBitset<W> &representative = fragmentPool<W>[bucket[0].representative];
+        if (vf2GraphIso(toLabelledGraph<W>(targetMolecule, univEdgeList, mask),
+                        toLabelledGraph<W>(targetMolecule, univEdgeList, representative)))
+            return &bucket[0];
+        bucket[0].hash.emplace(representative);
+    }
+    hash.emplace(mask);
+    for (fragmentClass<W> &cls : bucket)
     {
-        x = bitsetHashTable[mask].first;
+        if (!cls.hash)
+            cls.hash.emplace(fragmentPool<W>[cls.representative]);
+        if (*cls.hash == *hash)
+            return &cls;
     }
-    return x;
-}
\ No newline at end of file
+    return nullptr;
+}
+
+/**
+ * @brief Canonises the pooled mask with ID id. The caller holds canonMutex exclusively
+ */
+template <size_t W>
+static int canoniseLocked(maskId id, uint64_t signature)
+{
+    pair<pii *, bool> entry = bitsetHashTable<W>.tryEmplace(id);
+    if (!entry.second)
+        return entry.first->first;
+    vector<fragmentClass<W>> &bucket = graphHashMap<W>.buckets[signature];
+    optional<graphHash<W>> hash;
+    fragmentClass<W> *cls = matchClass<W>(bucket, id, hash);
+    if (cls == nullptr)
+    {
+        // A new isomorphism class gets the next canonical index
+        bucket.emplace_back(id, pii(graphHashMap<W>.classes++, 0));
+        cls = &bucket.back();
+        cls->hash = move(hash);
+    }
+    cls->value.second++;
+    *entry.first = cls->value;
+    return entry.first->first;
+}
+
+template <size_t W>
+int canonise(maskId id, uint64_t signature)
+{
+    pii found;
+    if (findCanonical<W>(id, found))
+        return found.first;
+    unique_lock<shared_mutex> lock(canonMutex);
+    return canoniseLocked<W>(id, signature);
+}
+
+template <size_t W>
+int canonise(maskId id)
+{
+    pii found;
+    if (findCanonical<W>(id, found))
+        return found.first;
+    uint64_t signature = fragmentSignature<W>(fragmentPool<W>[id]);
+    unique_lock<shared_mutex> lock(canonMutex);
+    return canoniseLocked<W>(id, signature);
+}
+
+template <size_t W>
+int canonise(standardBitset<W> &mask)
+{
+    pii found;
+    if (findCanonical<W>(mask, found))
+        return found.first;
+    uint64_t signature = fragmentSignature<W>(mask);
+    unique_lock<shared_mutex> lock(canonMutex);
+    return canoniseLocked<W>(fragmentPool<W>.intern(mask), signature);
+}
+
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_GRAPH_HASHES(W) \
+    template struct graphHash<W>; \
+    template bool findCanonical<W>(const standardBitset<W> &, pii &); \
+    template bool findCanonical<W>(maskId, pii &); \
+    template int canonise<W>(standardBitset<W> &); \
+    template int canonise<W>(maskId); \
+    template int canonise<W>(maskId, uint64_t); \
+    template uint64_t fragmentSignature<W>(const standardBitset<W> &); \
+    template uint64_t extendSignature<W>(uint64_t, const standardBitset<W> &, size_t);
+FOR_EACH_MASK_WIDTH(INSTANTIATE_GRAPH_HASHES)
@@ -12,7 +12,33 @@ std::string helpstring = R"(The following are possible flags for assemblyCpp:
 
 -pathway=x: if x is 1 (the default), a pathway file is generated, else if x is 0 no pathway will be generated
 
--removeHydrogens=x: removes explicit hydrogens if greater than 0 (default), else leaves in explicit hydrogens. Only applies to molfile inputs.)";
+-removeHydrogens=x: removes explicit hydrogens if greater than 0 (default), else leaves in explicit hydrogens. Only applies to molfile inputs.
+
+-threads=x: runs the branch-and-bound search on x threads using work stealing, default is 1. With more than one thread, runTime counts the processor time of all threads
+
+-bestFirst=x: if x is 1, assembly states are expanded in order of their lower bound instead of depth-first, so the search stops as soon as no remaining bound can beat the best pathway found. Runs on a single thread. Default is 0
+
+-frontierMax=x: number of states the best-first frontier may hold before further states are searched depth-first, default is 1,000,000
+
+-branchOrder=x: if x is 1, the children of each assembly state are searched in order of their lower bound, most promising first, else if x is 0 in the order they are generated. Default is 0
+
+-sliceNodes=x: if x is greater than 0, the first-level subtrees are searched round robin, each for x state expansions before yielding to the next, instead of one after another. Runs on a single thread. Default is 0
+
+-checkpoint=x: periodically writes the state of the search to the file x, so that it can be resumed after the process is stopped. Only the serial depth-first search writes checkpoints
+
+-checkpointTime=x: processor time between checkpoints, in the units of runTime, default is 10 minutes. 0 disables the time criterion
+
+-checkpointNodes=x: number of state expansions between checkpoints, default is 0 (disabled). Checkpoints are spaced out so that writing them takes at most about 5% of the runtime
+
+-resume=x: continues the search saved in the checkpoint file x, which must have been written for the same molecule and flags. The search continues depth-first on a single thread
+
+-ttMemory=x: limits the pathway hash table to about x MB. When it is full, the deepest states are forgotten first and are searched again if they are reached again, so the result is still exact. States on the best pathway found are kept. Default is 0 (no limit)
+
+-dive=x: before the exact search, runs a greedy dive that keeps the x states with the largest duplicates at each level, to start with a good upper bound. Its value, or none if it found nothing better than the starting incumbent, and its time are reported separately. Default is 0, which skips the dive
+
+-threshold=x: only decides whether the assembly index is at most x. The search prunes every state that cannot reach x and stops at the first pathway at or below x, which is written as the witness pathway. The output file reports <= x or > x instead of the exact index. Default is an exact search
+
+-maskKernels=x: instruction set of the kernels for masks of 256 bits or more, scalar, avx2 or avx512. Default is the fastest the CPU supports)";
 
 void help()
 {
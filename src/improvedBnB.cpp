@@ -1,39 +1,55 @@
 #include "improvedBnB.h"
-#include <algorithm>           // for max
+#include <algorithm>           // for max, partial_sort, stable_sort
+#include <atomic>              // for atomic
 #include <bitset>              // for bitset, hash, operator&
 #include <ctime>               // for clock, size_t
 #include <fstream>             // for operator<<, char_traits, basic_ostream
 #include <iostream>            // for cout
 #include <map>                 // for map, operator!=, _Rb_tree_iterator
+#include <mutex>               // for mutex, lock_guard
+#include <queue>               // for priority_queue
 #include <unordered_map>       // for unordered_map, _Node_iterator
 #include <unordered_set>       // for unordered_set
-#include <utility>             // for pair
+#include <utility>             // for pair, move
 #include <vector>              // for vector
-#include "assemblyState.h"     // for apWrapper, assemblyState, assemblyPath
+#include "assemblyState.h"     // for assemblyState, assemblyPath
+#include "checkpoint.h"        // for writeCheckpoint, readCheckpoint
 #include "dagEnumeration.h"    // for convertDag
 #include "duplicateMatching.h" // for dagDuplicateSet, initialDuplicateSet
+#include "dynamicBitset.h"     // for dynamicBitset
 #include "fragmentation.h"     // for fragmentAssemblyState, clearPathMap
-#include "globalPrimitives.h"  // for standardBitset, bitsetHashTable, inte...
-#include "graphHashes.h"       // for graphHash, canonise, graphHashMap
+#include "globalPrimitives.h"  // for standardBitset, interruptFlag, univEd...
+#include "graphHashes.h"       // for graphHash, canonise, findCanonical, gr...
+#include "maskKernels.h"       // for andCount, orReduce, orInto
+#include "maskPool.h"          // for fragmentPool, bitsetHashTable, maskId
 #include "molGraph.h"          // for molGraph, preprocessWriteback, target...
 #include "pathwayGenerator.h"  // for recoverPathway2
+#include "searchBounds.h"      // for openBounds
+#include "searchEngine.h"      // for searchEngine, rankedChild, compareRankedChild
+#include "transpositionTable.h" // for pathAssemblyMap, diveMap
+#include "treeCanon.h"         // for clearTreeCanon
+#include "workStealingPool.h"  // for workStealingPool, searchPool, searchTask
 
 using namespace std;
 
-bool initialRecursiveEnumeration(assemblyState &_target, std::vector<std::map<int, initialDuplicateSet>> &stmapVector, bool &earlyTerminate)
+/// Serialises updates of the best assembly index and pathway found so far
+static mutex incumbentMutex;
+
+template <size_t W>
+bool initialRecursiveEnumeration(assemblyState<W> &_target, std::vector<std::map<int, initialDuplicateSet<W>>> &stmapVector, bool &earlyTerminate)
 {
-    vector<std::unordered_map<standardBitset, pair<int, vector<standardBitset>>>> tempDag(2);
+    vector<std::unordered_map<maskId, pair<int, vector<maskId>>>> tempDag(2);
     int ordinal = MAX_INT;
-    vector<standardBitset> &masks = _target.masks;
+    vector<standardBitset<W>> &masks = _target.masks;
     bool alive = 0;
     size_t currSize = 1;
     int pr = 0;
     bool exitEnum = 0;
-    vector<standardBitset> targetMask(masks.size(), 0);
+    vector<standardBitset<W>> targetMask(masks.size(), 0);
 
-    vector<initialPotentialDuplicate> *matchingList1ptr = new vector<initialPotentialDuplicate>;
-    vector<initialPotentialDuplicate> &matchingList1 = *(matchingList1ptr);
-    std::unordered_set<standardBitset> maskMap;
+    vector<initialPotentialDuplicate<W>> *matchingList1ptr = new vector<initialPotentialDuplicate<W>>;
+    vector<initialPotentialDuplicate<W>> &matchingList1 = *(matchingList1ptr);
+    std::unordered_set<maskId> maskMap;
     
     // Find all one-bond duplicatable subgraphs
     for (size_t i = 0; i < masks.size(); i++)
@@ -42,27 +58,27 @@ bool initialRecursiveEnumeration(assemblyState &_target, std::vector<std::map<in
         {
             if (masks[i][j] != 0)
             {
-                initialPotentialDuplicate m(j, masks[i], i);
-                pair<int, vector<standardBitset>> p;
+                initialPotentialDuplicate<W> m(j, masks[i], i);
+                pair<int, vector<maskId>> p;
                 p.first = -1;
-                standardBitset b = 0;
-                b.set(j);
-                tempDag[0][b] = p;
+                tempDag[0][m.id] = p;
                 m.generateDAG(matchingList1, i, maskMap, tempDag);
             }
         }
     }
 
     bool active = 1, overweight = 0;
-    vector<initialPotentialDuplicate> *currMLptr = nullptr, *prevMLptr = matchingList1ptr;
+    vector<initialPotentialDuplicate<W>> *currMLptr = nullptr, *prevMLptr = matchingList1ptr;
     while (active)
     {
-        map<int, initialDuplicateSet> temp;
+        map<int, initialDuplicateSet<W>> temp;
         stmapVector.push_back(temp);
-        map<int, initialDuplicateSet> &stmap = stmapVector.back();
+        map<int, initialDuplicateSet<W>> &stmap = stmapVector.back();
         active = 0;
-        currMLptr = new vector<initialPotentialDuplicate>;
-        vector<initialPotentialDuplicate> &currML = *currMLptr, &prevML = *prevMLptr;
+        currMLptr = new vector<initialPotentialDuplicate<W>>;
+        vector<initialPotentialDuplicate<W>> &currML = *currMLptr, &prevML = *prevMLptr;
+        // Every mask of prevML is already in the pool, so the table is sized for all of them at once
+        bitsetHashTable<W>.reserve(fragmentPool<W>.size());
         // Iterate through all matching subgraphs from the previous matchlist
         for (size_t i = 0; i < prevML.size(); i++)
         {
@@ -71,19 +87,19 @@ bool initialRecursiveEnumeration(assemblyState &_target, std::vector<std::map<in
                 interruptFlag = 1;
                 return false;
             }
-            if (bitsetHashTable.size() > ENUM_MAX)
+            if (bitsetHashTable<W>.size() > ENUM_MAX)
             {
                 exitEnum = 1;
                 break;
             }
-            initialPotentialDuplicate &m = prevML[i];
+            initialPotentialDuplicate<W> &m = prevML[i];
 
-            int s = canonise(m.mask);
+            int s = canonise<W>(m.id, m.signature);
             if (s <= ordinal)
             {
                 if (stmap.count(s) == 0)
                 {
-                    initialDuplicateSet ss(currSize + 1, masks.size());
+                    initialDuplicateSet<W> ss(currSize + 1, masks.size());
                     ss.insert(m);
                     stmap[s] = ss;
                 }
@@ -111,14 +127,14 @@ bool initialRecursiveEnumeration(assemblyState &_target, std::vector<std::map<in
                 interruptFlag = 1;
                 return false;
             }
-            initialDuplicateSet &ss = it->second;
+            initialDuplicateSet<W> &ss = it->second;
             if (ss.isValid())
             {
                 active = 1;
                 if (!overweight)
                     alive |= ss.dagPopulator(currML, maskMap, tempDag);
                 int u = ENUM_MAX - currML.size();
-                if (bitsetHashTable.size() > u)
+                if (bitsetHashTable<W>.size() > u)
                 {
                     exitEnum = 1;
                     earlyTerminate = 1;
@@ -139,18 +155,19 @@ bool initialRecursiveEnumeration(assemblyState &_target, std::vector<std::map<in
     delete currMLptr;
     if (exitEnum)
         return false;
-    convertDag(tempDag);
+    convertDag<W>(tempDag);
     return alive;
 }
 
-int dagRecursiveEnumeration(assemblyState &_target, vector<map<int, dagDuplicateSet>> &stmapVector,
-                            vector<vector<standardBitset>> &targetMasks)
+template <size_t W>
+int dagRecursiveEnumeration(assemblyState<W> &_target, vector<map<int, dagDuplicateSet<W>>> &stmapVector,
+                            vector<vector<standardBitset<W>>> &targetMasks)
 {
     int ordinal = MAX_INT;
     // Set the maximum index of the fragment that may be chosen
-    if (bitsetHashTable.count(_target.masks.front()))
-        ordinal = bitsetHashTable[_target.masks.front()].first;
-    vector<standardBitset> &masks = _target.masks;
+    if (_target.frags.front().canon >= 0)
+        ordinal = _target.frags.front().canon;
+    vector<standardBitset<W>> &masks = _target.masks;
     bool alive = 0;
     size_t currSize = 1;
     int pr = 0;
@@ -163,9 +180,7 @@ int dagRecursiveEnumeration(assemblyState &_target, vector<map<int, dagDuplicate
         {
             if (masks[i][j] != 0)
             {
-                standardBitset b = 0;
-                b.set(j);
-                potentialDuplicate m(b, i, j);
+                potentialDuplicate<W> m(DAG<W>[0].ids[j], i, j);
                 dagGenerate(m, stmapVector[0], masks[i], currSize, ordinal, masks.size());
             }
         }
@@ -173,17 +188,17 @@ int dagRecursiveEnumeration(assemblyState &_target, vector<map<int, dagDuplicate
     bool active = 1, overweight = 0, last = 0;
     while (active)
     {
-        vector<standardBitset> targetMask(masks.size(), 0);
+        vector<standardBitset<W>> targetMask(masks.size(), 0);
         active = 0;
-        map<int, dagDuplicateSet> temp;
+        map<int, dagDuplicateSet<W>> temp;
         stmapVector.push_back(temp);
-        map<int, dagDuplicateSet> &stmap = stmapVector[stmapVector.size() - 2];
+        map<int, dagDuplicateSet<W>> &stmap = stmapVector[stmapVector.size() - 2];
         // Iterate through all matching subgraphs from the previous matchlist
         for (auto it = stmap.begin(); it != stmap.end(); ++it)
         {
             if (interruptFlag)
                 return false;
-            dagDuplicateSet &ss = it->second;
+            dagDuplicateSet<W> &ss = it->second;
             if (ss.isValid())
             {
                 active |= dagDuplicateGenerator(ss, stmapVector.back(), targetMask, masks, ordinal, overweight, last);
@@ -196,18 +211,26 @@ int dagRecursiveEnumeration(assemblyState &_target, vector<map<int, dagDuplicate
     }
     if (stmapVector.back().size() == 0)
         stmapVector.pop_back();
+    // Bonds that are in no duplicate are dropped, and a fragment that loses bonds is no longer the one canonised
     for (size_t i = 0; i < masks.size(); i++)
     {
         masks[i] &= targetMasks[0][i];
+        int size = masks[i].count();
+        if (size != _target.frags[i].size)
+        {
+            _target.idSum += stateKey::idKey(-1) - stateKey::idKey(_target.frags[i].canon);
+            _target.frags[i] = {size, -1};
+        }
     }
     return currSize;
 }
 
-int postFragmentationCutoff(assemblyState &target, standardBitset &matchMask, standardBitset &maxFragMask)
+template <size_t W>
+int postFragmentationCutoff(assemblyState<W> &target, standardBitset<W> &matchMask, standardBitset<W> &maxFragMask)
 {
     if (target.masks.size() < 2)
         return 0;
-    int maxFragSize = target.masks[0].count();
+    int maxFragSize = target.frags[0].size;
 
     /// mainSizeList is the vector of integers corresponding to the sizes of each fragment
     /// matchSizeList is the vector of integers corresponding to the sizes of each matching fragment bitset
@@ -223,32 +246,76 @@ int postFragmentationCutoff(assemblyState &target, standardBitset &matchMask, st
     maxFragSizeList[0] = maxFragSize;
     for (size_t i = 1; i < target.masks.size(); i++)
     {
-        mainSizeList[i] = target.masks[i].count();
-        matchSizeList[i] = (target.masks[i] & matchMask).count();
-        maxFragSizeList[i] = (target.masks[i] & maxFragMask).count();
+        mainSizeList[i] = target.frags[i].size;
+        matchSizeList[i] = andCount(target.masks[i], matchMask);
+        maxFragSizeList[i] = andCount(target.masks[i], maxFragMask);
     }
     int matchDB = target.maxDupBonds(mainSizeList, maxFragSize, matchSizeList);
     int maxFragDB = target.maxDupBonds(mainSizeList, maxFragSize, maxFragSizeList) - 1;
     return max(matchDB, maxFragDB);
 }
 
-bool dagRecursiveAssembly(assemblyState &input, int &AI)
+template <size_t W>
+void updateIncumbent(assemblyState<W> &input, atomic<int> &AI)
 {
-    recursiveCount++;
-    if (clock() - startTime > runTimeMax)
-        interruptFlag = 1;
-    if (interruptFlag)
-        return false;
+    if (input.AI() >= AI)
+        return;
+    lock_guard<mutex> lock(incumbentMutex);
     if (input.AI() < AI)
     {
         AI = input.AI();
         minAIfound = AI;
         minAssemblyPath = input.apPtr;
         cout << "time: " << clock() - startTime << " min AI found so far: " << AI << '\n';
+        // A decision query is answered by the first pathway found, since the search starts from threshold + 1
+        if (threshold >= 0)
+            interruptFlag = 1;
+    }
+}
+
+void closeSearchBound(int bound, atomic<int> &AI)
+{
+    openBounds.closeBound(bound);
+    int lowerBound = openBounds.lowerBound(AI);
+    if (lowerBound <= openBounds.reported)
+        return;
+    lock_guard<mutex> lock(incumbentMutex);
+    if (lowerBound > openBounds.reported)
+    {
+        openBounds.reported = lowerBound;
+        cout << "time: " << clock() - startTime << " proven lower bound: " << lowerBound
+             << " optimality gap: " << AI - lowerBound << '\n';
     }
+}
+
+template <size_t W>
+bool claimAssemblyState(assemblyState<W> &input, assemblyState<W> &as, validMatchings<W> &matching, transpositionTable &table)
+{
+    pii match, duplicate;
+    findCanonical<W>(matching.first, match);
+    findCanonical<W>(matching.second, duplicate);
+    stateKey key = as.assemblyHashCalculator();
+    pathPtr ap = table.tryClaim(key, as.sumDupBonds, input.apPtr, match.second, duplicate.second);
+    if (ap == nullptr)
+        return false;
+    as.ix = ++assemblyIx;
+    as.apPtr = move(ap);
+    return true;
+}
 
-    vector<map<int, dagDuplicateSet>> stmapVector;
-    vector<vector<standardBitset>> targetMasks;
+template <size_t W>
+bool generateChildren(assemblyState<W> &input, atomic<int> &AI, vector<rankedChild<W>> &children,
+                      vector<duplicateSetMasks<W>> &sets)
+{
+    recursiveCount++;
+    if (clock() - startTime > runTimeMax)
+        interruptFlag = 1;
+    if (interruptFlag)
+        return false;
+    updateIncumbent(input, AI);
+
+    vector<map<int, dagDuplicateSet<W>>> stmapVector;
+    vector<vector<standardBitset<W>>> targetMasks;
     int maxFragSize = dagRecursiveEnumeration(input, stmapVector, targetMasks);
 
     if (stmapVector.size() == 0 || interruptFlag)
@@ -270,29 +337,27 @@ bool dagRecursiveAssembly(assemblyState &input, int &AI)
     }
     for (size_t i = 0; i < input.masks.size(); i++)
     {
-        sizeList[i] = input.masks[i].count();
+        sizeList[i] = input.frags[i].size;
     }
 
     /// Begin iterating through the enumerated duplicatable fragments
     for (int j = stmapVector.size() - 1; j >= 0; j--)
     {
-        map<int, dagDuplicateSet> &stmap = stmapVector[j];
-        vector<standardBitset> stmapMaskList(input.masks.size(), 0);
-        standardBitset maskM = 0;
+        map<int, dagDuplicateSet<W>> &stmap = stmapVector[j];
+        vector<standardBitset<W>> stmapMaskList(input.masks.size(), 0);
+        standardBitset<W> maskM = 0;
         for (auto it = stmap.begin(); it != stmap.end(); ++it)
         {
-            dagDuplicateSet &ss = it->second;
+            dagDuplicateSet<W> &ss = it->second;
             if (!ss.dead)
             {
-                vector<validMatchings> matchings;
-                standardBitset maskC = 0;
+                vector<validMatchings<W>> matchings;
+                standardBitset<W> maskC = 0;
 
+                orReduce(maskC, ss.maskList);
                 for (size_t i = 0; i < ss.maskList.size(); i++)
-                {
-                    maskC |= ss.maskList[i];
-                    stmapMaskList[i] |= ss.maskList[i];
-                }
-                maskM |= maskC;
+                    orInto(stmapMaskList[i], ss.maskList[i]);
+                orInto(maskM, maskC);
                 int dupBondsMaxFrag = input.maxDupBonds(sizeList, ss.size, stmapMaskList);
 
                 int temp = fragSizeListMax[ss.size - 2] - 1;
@@ -310,50 +375,11 @@ bool dagRecursiveAssembly(assemblyState &input, int &AI)
                     {
                         ss.generateMatchings(matchings);
                     }
+                    // The children are fragmented when their turn comes, against the incumbent of that time
+                    if (!matchings.empty())
+                        sets.emplace_back(maskC, maskM);
                     for (int i = matchings.size() - 1; i >= 0; i--)
-                    {
-                        assemblyState as;
-                        fragmentAssemblyState(input, matchings[i], as);
-
-                        int sumDupBonds = input.sumDupBonds + matchings[i].maxFragSize - 1;
-                        as.sumDupBonds = sumDupBonds;
-                        int temp = postFragmentationCutoff(as, maskC, maskM);
-                        if (as.lowBoundAI(matchings[i].maxFragSize, temp) < AI)
-                        {
-                            apWrapper ap;
-                            ap.ap = new assemblyPath;
-                            ap.ap->parent = input.apPtr;
-                            ap.ap->key = as.assemblyHashCalculator();
-
-                            if (pathAssemblyMap.count(ap) == 0)
-                            {
-                                assemblyIx++;
-                                as.ix = assemblyIx;
-                                as.apPtr = ap.ap;
-                                ap.ap->sumDupBonds = sumDupBonds;
-                                ap.ap->match = bitsetHashTable[matchings[i].first].second;
-                                ap.ap->duplicate = bitsetHashTable[matchings[i].second].second;
-                                pathAssemblyMap.insert(ap);
-                                dagRecursiveAssembly(as, AI);
-                            }
-                            else
-                            {
-                                auto it2 = pathAssemblyMap.find(ap);
-                                delete ap.ap;
-                                if (sumDupBonds > (*it2).ap->sumDupBonds)
-                                {
-                                    assemblyIx++;
-                                    as.ix = assemblyIx;
-                                    as.apPtr = (*it2).ap;
-                                    (*it2).ap->sumDupBonds = sumDupBonds;
-                                    (*it2).ap->match = bitsetHashTable[matchings[i].first].second;
-                                    (*it2).ap->duplicate = bitsetHashTable[matchings[i].second].second;
-                                    (*it2).ap->parent = input.apPtr;
-                                    dagRecursiveAssembly(as, AI);
-                                }
-                            }
-                        }
-                    }
+                        children.emplace_back(matchings[i], earlyAIBound, int(sets.size()) - 1);
                 }
             }
         }
@@ -361,7 +387,251 @@ bool dagRecursiveAssembly(assemblyState &input, int &AI)
     return true;
 }
 
-bool initialRecursiveAssembly(assemblyState &input, int &AI, ofstream &ofs)
+template <size_t W>
+int fragmentChild(assemblyState<W> &input, rankedChild<W> &child, duplicateSetMasks<W> &set, assemblyState<W> &as)
+{
+    fragmentAssemblyState(input, child.matching, as);
+    as.sumDupBonds = input.sumDupBonds + child.matching.maxFragSize - 1;
+    int temp = postFragmentationCutoff(as, set.matchMask, set.maxFragMask);
+    // Both bounds hold, and the one of the set may be the larger
+    child.bound = max(child.bound, as.lowBoundAI(child.matching.maxFragSize, temp));
+    return child.bound;
+}
+
+template <size_t W>
+bool expandAssemblyState(assemblyState<W> &input, atomic<int> &AI, const childHandler<W> &searchChild,
+                         transpositionTable &table)
+{
+    vector<rankedChild<W>> children;
+    vector<duplicateSetMasks<W>> sets;
+    if (!generateChildren(input, AI, children, sets))
+        return false;
+    if (branchOrder)
+        stable_sort(children.begin(), children.end(), compareRankedChild());
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        rankedChild<W> &c = children[i];
+        if (c.bound >= AI)
+            continue;
+        assemblyState<W> as;
+        if (fragmentChild(input, c, sets[c.set], as) < AI && claimAssemblyState(input, as, c.matching, table))
+            searchChild(as, c.bound);
+    }
+    return true;
+}
+
+template <size_t W>
+bool dagRecursiveAssembly(assemblyState<W> &input, int bound, atomic<int> &AI)
+{
+    searchEngine<W> engine(input, bound, AI);
+    return engine.run();
+}
+
+template <size_t W>
+void searchSubtree(searchTask<W> &t, atomic<int> &AI)
+{
+    // The incumbent may have improved since the task was queued. An interrupted subtree stays open, so its bound
+    // still counts towards the proven lower bound
+    if (t.bound < AI)
+        dagRecursiveAssembly(t.state, t.bound, AI);
+    else if (!interruptFlag)
+        closeSearchBound(t.bound, AI);
+}
+
+/**
+ * @brief Orders the best-first frontier so that the lowest bound is on top. Ties go to the state with more
+ * duplicated bonds, which is closer to a complete pathway
+ */
+struct compareSearchTask
+{
+    template <size_t W>
+    bool operator()(const searchTask<W> &a, const searchTask<W> &b) const
+    {
+        if (a.bound != b.bound)
+            return a.bound > b.bound;
+        return a.state.sumDupBonds < b.state.sumDupBonds;
+    }
+};
+
+template <size_t W>
+void bestFirstAssembly(vector<searchTask<W>> &roots, atomic<int> &AI)
+{
+    priority_queue<searchTask<W>, vector<searchTask<W>>, compareSearchTask> frontier(compareSearchTask(), move(roots));
+    bool overflowed = 0;
+    while (!frontier.empty() && !interruptFlag)
+    {
+        searchTask<W> t = frontier.top();
+        frontier.pop();
+        // Every remaining state is bounded below by t.bound, so nothing left can beat the incumbent
+        if (t.bound >= AI)
+            break;
+        // Stale entry: the state has since been queued again with more duplicated bonds
+        if (t.state.sumDupBonds < t.state.apPtr->sumDupBonds)
+        {
+            closeSearchBound(t.bound, AI);
+            continue;
+        }
+        if (frontier.size() < frontierMax)
+        {
+            expandAssemblyState<W>(t.state, AI, [&frontier](assemblyState<W> &as, int bound)
+                                {
+                                    openBounds.openBound(bound);
+                                    frontier.emplace(as, bound); });
+            if (!interruptFlag)
+                closeSearchBound(t.bound, AI);
+        }
+        else
+        {
+            if (!overflowed)
+            {
+                cout << "time: " << clock() - startTime << " frontier limit reached, continuing depth-first\n";
+                overflowed = 1;
+            }
+            searchSubtree(t, AI);
+        }
+    }
+}
+
+template <size_t W>
+void depthFirstAssembly(vector<searchTask<W>> &roots, atomic<int> &AI, vector<searchFrame<W>> &resumeStack)
+{
+    bool checkpointing = !checkpointFile.empty() && (checkpointTime > 0 || checkpointNodes > 0);
+    // With only a time interval, the engine yields every CHECKPOINT_POLL expansions to look at the clock
+    const size_t CHECKPOINT_POLL = 1000;
+    size_t slice = !checkpointing ? 0 : checkpointNodes > 0 ? checkpointNodes : CHECKPOINT_POLL;
+    clock_t lastCheckpoint = clock(), writeTime = 0;
+    size_t sinceCheckpoint = 0;
+    for (size_t i = 0; i < roots.size(); i++)
+    {
+        if (interruptFlag)
+            return;
+        searchEngine<W> engine(roots[i].state, roots[i].bound, AI);
+        if (i == 0 && !resumeStack.empty())
+            engine.resume(resumeStack);
+        while (roots[i].bound < AI && !engine.run(slice))
+        {
+            if (interruptFlag)
+                return;
+            sinceCheckpoint += slice;
+            clock_t now = clock();
+            bool due = (checkpointNodes > 0 && sinceCheckpoint >= checkpointNodes) ||
+                       (checkpointTime > 0 && (unsigned long long)(now - lastCheckpoint) >= checkpointTime);
+            // Leave at least 20 times the last write time between checkpoints, so writing them takes at most
+            // about 5% of the runtime however large the tables grow
+            if (!due || now - lastCheckpoint < 20 * writeTime)
+                continue;
+            if (writeCheckpoint(checkpointFile, roots, i, engine.stack, AI))
+                cout << "time: " << clock() - startTime << " checkpoint written to " << checkpointFile << '\n';
+            else
+                cout << "time: " << clock() - startTime << " could not write checkpoint to " << checkpointFile << '\n';
+            lastCheckpoint = clock();
+            writeTime = lastCheckpoint - now;
+            sinceCheckpoint = 0;
+        }
+        engine.prune();
+    }
+}
+
+template <size_t W>
+void slicedAssembly(vector<searchTask<W>> &roots, atomic<int> &AI)
+{
+    vector<searchEngine<W> *> engines(roots.size());
+    for (size_t i = 0; i < roots.size(); i++)
+        engines[i] = new searchEngine<W>(roots[i].state, roots[i].bound, AI);
+    size_t active = roots.size();
+    while (active > 0 && !interruptFlag)
+    {
+        for (size_t i = 0; i < roots.size() && !interruptFlag; i++)
+        {
+            if (engines[i] == nullptr)
+                continue;
+            // A subtree needs no more slices once the incumbent has reached its bound
+            if (roots[i].bound >= AI || engines[i]->run(sliceNodes))
+            {
+                engines[i]->prune();
+                delete engines[i];
+                engines[i] = nullptr;
+                active--;
+            }
+        }
+    }
+    for (size_t i = 0; i < engines.size(); i++)
+        delete engines[i];
+}
+
+/**
+ * @brief Orders the states of the greedy dive, those that took the largest duplicates first. Ties go to the
+ * lower bound
+ */
+struct compareDiveTask
+{
+    template <size_t W>
+    bool operator()(const searchTask<W> &a, const searchTask<W> &b) const
+    {
+        if (a.state.sumDupBonds != b.state.sumDupBonds)
+            return a.state.sumDupBonds > b.state.sumDupBonds;
+        return a.bound < b.bound;
+    }
+};
+
+/**
+ * @brief Child of a state of the greedy dive, not yet fragmented
+ */
+template <size_t W>
+struct diveCandidate
+{
+    /// @brief index of the state in the beam
+    size_t parent;
+    rankedChild<W> child;
+    /// @brief duplicated bonds of the child, the key of compareDiveTask
+    int sumDupBonds;
+};
+
+template <size_t W>
+void greedyDive(vector<searchTask<W>> &roots, atomic<int> &AI)
+{
+    vector<searchTask<W>> beam(roots);
+    if (beam.size() > diveBeam)
+    {
+        partial_sort(beam.begin(), beam.begin() + diveBeam, beam.end(), compareDiveTask());
+        beam.resize(diveBeam);
+    }
+    while (!beam.empty() && !interruptFlag)
+    {
+        // The children of the beam are ranked by their matchings as compareDiveTask would rank them, with the bound
+        // of their duplicate set, and only those that make the next beam are fragmented
+        vector<diveCandidate<W>> candidates;
+        vector<vector<duplicateSetMasks<W>>> sets(beam.size());
+        for (size_t i = 0; i < beam.size(); i++)
+        {
+            vector<rankedChild<W>> children;
+            generateChildren(beam[i].state, AI, children, sets[i]);
+            for (size_t j = 0; j < children.size(); j++)
+                candidates.push_back({i, children[j], beam[i].state.sumDupBonds + children[j].matching.maxFragSize - 1});
+        }
+        stable_sort(candidates.begin(), candidates.end(), [](const diveCandidate<W> &a, const diveCandidate<W> &b)
+                    {
+                        if (a.sumDupBonds != b.sumDupBonds)
+                            return a.sumDupBonds > b.sumDupBonds;
+                        return a.child.bound < b.child.bound; });
+        vector<searchTask<W>> next;
+        for (size_t k = 0; k < candidates.size() && next.size() < diveBeam && !interruptFlag; k++)
+        {
+            diveCandidate<W> &c = candidates[k];
+            if (c.child.bound >= AI)
+                continue;
+            assemblyState<W> &input = beam[c.parent].state;
+            assemblyState<W> as;
+            if (fragmentChild(input, c.child, sets[c.parent][c.child.set], as) < AI &&
+                claimAssemblyState(input, as, c.child.matching, diveMap))
+                next.emplace_back(as, c.child.bound);
+        }
+        beam.swap(next);
+    }
+}
+
+template <size_t W>
+bool initialRecursiveAssembly(assemblyState<W> &input, atomic<int> &AI, ofstream &ofs, const childHandler<W> &searchChild)
 {
     bool earlyTerminate = 0;
     recursiveCount++;
@@ -369,14 +639,13 @@ bool initialRecursiveAssembly(assemblyState &input, int &AI, ofstream &ofs)
         interruptFlag = 1;
     if (interruptFlag)
         return false;
-    if (input.AI() < AI)
-    {
-        AI = input.AI();
-        minAIfound = AI;
-        minAssemblyPath = input.apPtr;
-        cout << "time: " << clock() - startTime << " min AI found so far: " << AI << '\n';
-    }
-    vector<map<int, initialDuplicateSet>> stmapVector;
+    updateIncumbent(input, AI);
+    if (interruptFlag)
+        return false;
+    // The root stays open until all of its children have been handed to searchChild
+    int rootBound = input.lowBoundAI();
+    openBounds.openBound(rootBound);
+    vector<map<int, initialDuplicateSet<W>>> stmapVector;
     initialRecursiveEnumeration(input, stmapVector, earlyTerminate);
     if (earlyTerminate)
     {
@@ -388,75 +657,198 @@ bool initialRecursiveAssembly(assemblyState &input, int &AI, ofstream &ofs)
         return false;
 
     if (stmapVector.size() == 0)
+    {
+        closeSearchBound(rootBound, AI);
         return false;
+    }
     /// Begin iterating through the enumerated duplicatable fragments
     for (int j = stmapVector.size() - 1; j >= 0; j--)
     {
-        map<int, initialDuplicateSet> &stmap = stmapVector[j];
+        map<int, initialDuplicateSet<W>> &stmap = stmapVector[j];
         for (auto it = stmap.begin(); it != stmap.end(); ++it)
         {
-            initialDuplicateSet &ss = it->second;
-            vector<validMatchings> matchings;
+            initialDuplicateSet<W> &ss = it->second;
+            vector<validMatchings<W>> matchings;
             if (ss.list.size() > 1)
             {
                 ss.generateMatchings(matchings);
             }
-            standardBitset maskC = 0;
-            for (size_t i = 0; i < ss.maskList.size(); i++)
-                maskC |= ss.maskList[i];
+            standardBitset<W> maskC = 0;
+            orReduce(maskC, ss.maskList);
             for (int i = matchings.size() - 1; i >= 0; i--)
             {
-                assemblyState as;
+                assemblyState<W> as;
                 fragmentAssemblyState(input, matchings[i], as);
                 int sumDupBonds = input.sumDupBonds + matchings[i].maxFragSize - 1;
                 as.sumDupBonds = sumDupBonds;
-                if (as.lowBoundAI() < AI)
-                {
-                    apWrapper ap;
-                    ap.ap = new assemblyPath;
-                    ap.ap->parent = input.apPtr;
-                    ap.ap->key = as.assemblyHashCalculator();
-
-                    if (pathAssemblyMap.count(ap) == 0)
-                    {
-                        assemblyIx++;
-                        as.ix = assemblyIx;
-                        as.apPtr = ap.ap;
-                        ap.ap->sumDupBonds = sumDupBonds;
-                        ap.ap->match = bitsetHashTable[matchings[i].first].second;
-                        ap.ap->duplicate = bitsetHashTable[matchings[i].second].second;
-                        pathAssemblyMap.insert(ap);
-                        dagRecursiveAssembly(as, AI);
-                    }
-                    else
-                    {
-                        auto it2 = pathAssemblyMap.find(ap);
-                        delete ap.ap;
-                        if (sumDupBonds > (*it2).ap->sumDupBonds)
-                        {
-                            assemblyIx++;
-                            as.ix = assemblyIx;
-                            as.apPtr = (*it2).ap;
-                            (*it2).ap->sumDupBonds = sumDupBonds;
-                            (*it2).ap->match = bitsetHashTable[matchings[i].first].second;
-                            (*it2).ap->duplicate = bitsetHashTable[matchings[i].second].second;
-                            (*it2).ap->parent = input.apPtr;
-                            dagRecursiveAssembly(as, AI);
-                        }
-                    }
-                }
+                int bound = as.lowBoundAI();
+                if (bound < AI && claimAssemblyState(input, as, matchings[i]))
+                    searchChild(as, bound);
             }
         }
     }
+    closeSearchBound(rootBound, AI);
     return true;
 }
 
+template <size_t W>
+void decisionVerdict(atomic<int> &AI, int offset, vector<edgeL> &removedEdges, ofstream &ofs)
+{
+    int found = AI - offset;
+    if (found <= threshold)
+    {
+        cout << "time: " << clock() - startTime << " assembly index <= " << threshold << ": yes, pathway with "
+             << found << " found\n";
+        if (isPathway)
+            recoverPathway2<W>(removedEdges);
+        ofs << "<= " << threshold << '\n';
+        ofs << "verdict: yes, witness pathway with assembly index " << found << '\n';
+    }
+    else if (interruptFlag)
+    {
+        cout << "time: " << clock() - startTime << " assembly index <= " << threshold << ": undecided\n";
+        ofs << "undecided\n";
+        ofs << "verdict: undecided, search stopped before a pathway or a proof was found\n";
+    }
+    else
+    {
+        cout << "time: " << clock() - startTime << " assembly index <= " << threshold << ": no\n";
+        ofs << "> " << threshold << '\n';
+        ofs << "verdict: no\n";
+    }
+}
+
+template <size_t W>
+void searchMolecule(vector<edgeL> &removedEdges, int disjointFragments, ofstream &ofs)
+{
+    bitsetHashTable<W>.clear();
+    graphHashMap<W>.clear();
+    clearTreeCanon();
+    fragmentPool<W>.clear();
+    prepareFragmentSignatures();
+    allEdges<W> = 0;
+    for (size_t i = 0; i < univEdgeList.size(); i++)
+        allEdges<W>.set(i);
+    assemblyState<W> as;
+    as.addFragment(allEdges<W>, -1);
+    atomic<int> AI(MAX_INT);
+    // A resumed search takes its tables, incumbent and frontier from the checkpoint
+    vector<searchTask<W>> resumeRoots;
+    vector<searchFrame<W>> resumeStack;
+    bool resumed = 0;
+    if (!resumeFile.empty())
+    {
+        resumed = readCheckpoint(resumeFile, resumeRoots, resumeStack, AI);
+        if (resumed)
+            cout << "resuming from " << resumeFile << " with min AI found so far: " << AI << '\n';
+        else
+            cout << "could not resume from " << resumeFile << ", starting a new search\n";
+    }
+    stateKey rootKey = as.assemblyHashCalculator();
+    as.apPtr = pathAssemblyMap.tryClaim(rootKey, 0, nullptr, 0, 0);
+    if (as.apPtr == nullptr)
+        as.apPtr = pathAssemblyMap.find(rootKey);
+    int offset = disjointCompensation ? disjointFragments - 1 : 0;
+    aiOffset = offset;
+    // A decision query only looks for pathways at or below the threshold, so it starts as if one above it was found
+    if (!resumed && threshold >= 0)
+        AI = threshold + offset + 1;
+    openBounds.reset(totalBonds);
+    for (size_t i = 0; i < resumeRoots.size(); i++)
+        openBounds.openBound(resumeRoots[i].bound);
+    // First-level states are collected before any is searched, so that all of them are open from the start
+    vector<searchTask<W>> roots;
+    // A resumed search takes its first-level states from the checkpoint instead. Any found again here were
+    // evicted from the pathway hash table, and have already been searched or are in the checkpoint
+    initialRecursiveAssembly<W>(as, AI, ofs, [&roots, resumed](assemblyState<W> &child, int bound)
+                             {
+                                 if (resumed)
+                                     return;
+                                 openBounds.openBound(bound);
+                                 roots.emplace_back(child, bound); });
+    if (resumed)
+        roots.swap(resumeRoots);
+    clock_t diveTime = 0;
+    // AI of the pathway found by the dive, MAX_INT if it found none better than the incumbent it started from
+    int diveAI = MAX_INT;
+    if (diveBeam > 0 && !resumed && !interruptFlag)
+    {
+        int startAI = AI;
+        diveTime = clock();
+        greedyDive(roots, AI);
+        diveTime = clock() - diveTime;
+        if (AI < startAI)
+            diveAI = AI;
+        cout << "time: " << clock() - startTime << " greedy dive (beam " << diveBeam << ") found AI: ";
+        if (diveAI < MAX_INT)
+            cout << diveAI;
+        else
+            cout << "none";
+        cout << " in " << diveTime << '\n';
+    }
+    // A resumed frontier keeps the order it was checkpointed in, since its stack belongs to roots[0]
+    if (branchOrder && !resumed)
+        stable_sort(roots.begin(), roots.end(), [](const searchTask<W> &a, const searchTask<W> &b)
+                    { return a.bound < b.bound; });
+    if (!checkpointFile.empty() && (bestFirst || numThreads > 1 || sliceNodes > 0))
+        cout << "checkpoints are only written by the serial depth-first search\n";
+    // The frontier of a checkpoint can only be continued by the search that wrote it
+    if (resumed)
+        depthFirstAssembly(roots, AI, resumeStack);
+    else if (bestFirst)
+        bestFirstAssembly(roots, AI);
+    else if (numThreads > 1)
+    {
+        // The first-level subtrees become the initial tasks of the pool
+        searchPool<W> = new workStealingPool<W>(numThreads);
+        for (size_t i = 0; i < roots.size(); i++)
+            searchPool<W>->submit(roots[i].state, roots[i].bound);
+        roots.clear();
+        searchPool<W>->run([&AI](searchTask<W> &t)
+                        { searchSubtree(t, AI); });
+        delete searchPool<W>;
+        searchPool<W> = nullptr;
+    }
+    else if (sliceNodes > 0)
+        slicedAssembly(roots, AI);
+    else
+        depthFirstAssembly(roots, AI, resumeStack);
+    if (pathAssemblyMap.evictions > 0)
+        cout << "time: " << clock() - startTime << " states evicted from the pathway hash table: "
+             << pathAssemblyMap.evictions << '\n';
+    if (threshold >= 0)
+        decisionVerdict<W>(AI, offset, removedEdges, ofs);
+    else
+    {
+        int lowerBound = openBounds.lowerBound(AI);
+        cout << "time: " << clock() - startTime << " min AI found: " << AI << " proven lower bound: " << lowerBound
+             << " optimality gap: " << AI - lowerBound << '\n';
+        if (isPathway)
+            recoverPathway2<W>(removedEdges);
+        ofs << AI.load() - offset << '\n';
+    }
+    if (diveBeam > 0 && !resumed)
+    {
+        ofs << "greedy dive (beam " << diveBeam << "): ";
+        if (diveAI < MAX_INT)
+            ofs << diveAI - offset;
+        else
+            ofs << "none";
+        ofs << ", time: " << diveTime << '\n';
+    }
+    // Drop the last references into the pathway hash tables, so that their nodes are released a slab at a time
+    roots.clear();
+    resumeRoots.clear();
+    resumeStack.clear();
+    as.apPtr = nullptr;
+    clearPathMap();
+}
+
 void improvedBnB(molGraph &mg, ofstream &ofs)
 {
     startTime = clock();
     clearPathMap();
-    bitsetHashTable.clear();
-    graphHashMap.clear();
+    pathAssemblyMap.setMemoryLimit(ttMemory << 20);
     vector<edgeL> removedEdges;
     totalBonds = mg.totalBonds;
     originalEdgeList = mg.writeEdgeList();
@@ -464,24 +856,18 @@ void improvedBnB(molGraph &mg, ofstream &ofs)
     originalMolecule = mg;
     targetMolecule = preprocessWriteback(mg, removedEdges);
     univEdgeList = targetMolecule.writeEdgeList();
-    allEdges = 0;
-    for (size_t i = 0; i < univEdgeList.size(); i++)
-        allEdges.set(i);
-    assemblyState as;
-    as.masks.push_back(allEdges);
-    apWrapper ap;
-    ap.ap = new assemblyPath;
-    ap.ap->parent = nullptr;
-    ap.ap->key = as.assemblyHashCalculator();
-    ap.ap->sumDupBonds = 0;
-    pathAssemblyMap.insert(ap);
-    as.apPtr = ap.ap;
-    int AI = MAX_INT;
-    initialRecursiveAssembly(as, AI, ofs);
-    if (isPathway)
-        recoverPathway2(removedEdges);
-    if (disjointCompensation)
-        ofs << AI - disjointFragments + 1 << '\n';
-    else
-        ofs << AI << '\n';
-}
\ No newline at end of file
+    maskWidth = selectMaskWidth(univEdgeList.size(), targetMolecule.mg.size());
+    if (maskWidth == DYNAMIC_WIDTH)
+        dynamicBitset::setWidth(max(univEdgeList.size() + 1, targetMolecule.mg.size()));
+    dispatchMaskWidth(maskWidth, [&](auto width)
+                      { searchMolecule<decltype(width)::value>(removedEdges, disjointFragments, ofs); });
+}
+
+/// Explicit instantiations for every mask width of the functions the search engine calls
+#define INSTANTIATE_IMPROVED_BNB(W) \
+    template bool claimAssemblyState<W>(assemblyState<W> &, assemblyState<W> &, validMatchings<W> &, \
+                                        transpositionTable &); \
+    template bool generateChildren<W>(assemblyState<W> &, atomic<int> &, vector<rankedChild<W>> &, \
+                                      vector<duplicateSetMasks<W>> &); \
+    template int fragmentChild<W>(assemblyState<W> &, rankedChild<W> &, duplicateSetMasks<W> &, assemblyState<W> &);
+FOR_EACH_MASK_WIDTH(INSTANTIATE_IMPROVED_BNB)
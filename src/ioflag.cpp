@@ -1,10 +1,12 @@
 #include "ioflag.h"
 #include <stdlib.h>           // for atoll
 #include <iosfwd>             // for std
-#include <string>             // for basic_string, string, stoi, allocator
+#include <iostream>           // for cout
+#include <string>             // for basic_string, string, stoi, stoull, allocator
 #include <unordered_map>      // for unordered_map
 #include <vector>             // for vector
-#include "globalPrimitives.h" // for ENUM_MAX, disjointCompensation, isPathway
+#include "globalPrimitives.h" // for ENUM_MAX, disjointCompensation, isPathway, numThreads, bestFirst, branchOrder, sliceNodes, checkpointFile, ttMemory, diveBeam, threshold
+#include "maskKernels.h"      // for selectMaskKernels, maskKernels
 
 using namespace std;
 
@@ -33,6 +35,74 @@ void owDisjointCompensate(string &_removeHydrogens)
     disjointCompensation = stoi(_removeHydrogens);
 }
 
+void owThreads(string &_threads)
+{
+    numThreads = stoi(_threads);
+    if (numThreads < 1)
+        numThreads = 1;
+}
+
+void owBestFirst(string &_bestFirst)
+{
+    bestFirst = stoi(_bestFirst);
+}
+
+void owFrontierMax(string &_frontierMax)
+{
+    frontierMax = stoull(_frontierMax);
+}
+
+void owBranchOrder(string &_branchOrder)
+{
+    branchOrder = stoi(_branchOrder);
+}
+
+void owSliceNodes(string &_sliceNodes)
+{
+    sliceNodes = stoull(_sliceNodes);
+}
+
+void owCheckpoint(string &_checkpoint)
+{
+    checkpointFile = _checkpoint;
+}
+
+void owCheckpointTime(string &_checkpointTime)
+{
+    checkpointTime = atoll(_checkpointTime.c_str());
+}
+
+void owCheckpointNodes(string &_checkpointNodes)
+{
+    checkpointNodes = stoull(_checkpointNodes);
+}
+
+void owResume(string &_resume)
+{
+    resumeFile = _resume;
+}
+
+void owTtMemory(string &_ttMemory)
+{
+    ttMemory = stoull(_ttMemory);
+}
+
+void owDiveBeam(string &_diveBeam)
+{
+    diveBeam = stoull(_diveBeam);
+}
+
+void owThreshold(string &_threshold)
+{
+    threshold = stoi(_threshold);
+}
+
+void owMaskKernels(string &_maskKernels)
+{
+    if (!selectMaskKernels(_maskKernels))
+        cout << "mask kernels " << _maskKernels << " not supported, using " << maskKernels.name << '\n';
+}
+
 std::unordered_map<string, void (*)(string &)> fptrTable;
 
 void fillFptrTable()
@@ -48,6 +118,32 @@ void fillFptrTable()
     fptrTable[string("removeHydrogens")] = f;
     f = &owDisjointCompensate;
     fptrTable[string("compensateDisjoint")] = f;
+    f = &owThreads;
+    fptrTable[string("threads")] = f;
+    f = &owBestFirst;
+    fptrTable[string("bestFirst")] = f;
+    f = &owFrontierMax;
+    fptrTable[string("frontierMax")] = f;
+    f = &owBranchOrder;
+    fptrTable[string("branchOrder")] = f;
+    f = &owSliceNodes;
+    fptrTable[string("sliceNodes")] = f;
+    f = &owCheckpoint;
+    fptrTable[string("checkpoint")] = f;
+    f = &owCheckpointTime;
+    fptrTable[string("checkpointTime")] = f;
+    f = &owCheckpointNodes;
+    fptrTable[string("checkpointNodes")] = f;
+    f = &owResume;
+    fptrTable[string("resume")] = f;
+    f = &owTtMemory;
+    fptrTable[string("ttMemory")] = f;
+    f = &owDiveBeam;
+    fptrTable[string("dive")] = f;
+    f = &owThreshold;
+    fptrTable[string("threshold")] = f;
+    f = &owMaskKernels;
+    fptrTable[string("maskKernels")] = f;
 }
 
 void flagParser(int argc, char **argv)
@@ -0,0 +1,184 @@
+#include "maskKernels.h"
+#include <bitset>  // for bitset
+#include <cstddef> // for size_t
+#include <cstdint> // for uint64_t
+#include <string>  // for string
+#include <vector>  // for vector
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h> // for AVX2 and AVX-512 intrinsics
+#define MASK_KERNELS_X86
+#endif
+
+using namespace std;
+
+static bool scalarSubset(const uint64_t *a, const uint64_t *b, size_t words)
+{
+    for (size_t i = 0; i < words; i++)
+        if (a[i] & ~b[i])
+            return false;
+    return true;
+}
+
+static bool scalarDisjoint(const uint64_t *a, const uint64_t *b, size_t words)
+{
+    for (size_t i = 0; i < words; i++)
+        if (a[i] & b[i])
+            return false;
+    return true;
+}
+
+static size_t scalarAndCount(const uint64_t *a, const uint64_t *b, size_t words)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < words; i++)
+        n += bitset<64>(a[i] & b[i]).count();
+    return n;
+}
+
+static void scalarOrReduce(uint64_t *dst, const uint64_t *const *srcs, size_t n, size_t words)
+{
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < words; i++)
+            dst[i] |= srcs[j][i];
+}
+
+static const maskKernelSet scalarKernels = {"scalar", scalarSubset, scalarDisjoint, scalarAndCount, scalarOrReduce};
+
+#ifdef MASK_KERNELS_X86
+/// Popcount of the AND of two masks with the popcnt instruction, shared by the AVX2 and AVX-512 kernels. Masks are
+/// at most a few words, too few for a vectorised popcount to pay off
+__attribute__((target("popcnt"))) static size_t popcntAndCount(const uint64_t *a, const uint64_t *b, size_t words)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < words; i++)
+        n += _mm_popcnt_u64(a[i] & b[i]);
+    return n;
+}
+
+__attribute__((target("avx2"))) static bool avx2Subset(const uint64_t *a, const uint64_t *b, size_t words)
+{
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4)
+    {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        if (!_mm256_testc_si256(vb, va))
+            return false;
+    }
+    for (; i < words; i++)
+        if (a[i] & ~b[i])
+            return false;
+    return true;
+}
+
+__attribute__((target("avx2"))) static bool avx2Disjoint(const uint64_t *a, const uint64_t *b, size_t words)
+{
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4)
+    {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        if (!_mm256_testz_si256(va, vb))
+            return false;
+    }
+    for (; i < words; i++)
+        if (a[i] & b[i])
+            return false;
+    return true;
+}
+
+__attribute__((target("avx2"))) static void avx2OrReduce(uint64_t *dst, const uint64_t *const *srcs, size_t n,
+                                                         size_t words)
+{
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4)
+    {
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        for (size_t j = 0; j < n; j++)
+            acc = _mm256_or_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(srcs[j] + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), acc);
+    }
+    for (; i < words; i++)
+        for (size_t j = 0; j < n; j++)
+            dst[i] |= srcs[j][i];
+}
+
+/// Lanes of a 512-bit register holding the words from i on, for the masked loads of the tail
+__attribute__((target("avx512f"))) static __mmask8 tailLanes(size_t i, size_t words)
+{
+    return words - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (words - i)) - 1);
+}
+
+__attribute__((target("avx512f"))) static bool avx512Subset(const uint64_t *a, const uint64_t *b, size_t words)
+{
+    for (size_t i = 0; i < words; i += 8)
+    {
+        __mmask8 lanes = tailLanes(i, words);
+        __m512i va = _mm512_mask_loadu_epi64(_mm512_setzero_si512(), lanes, a + i);
+        __m512i vb = _mm512_mask_loadu_epi64(_mm512_setzero_si512(), lanes, b + i);
+        // a & b != a rather than a & ~b, as GCC's andnot starts from an undefined register and warns
+        if (_mm512_cmpneq_epi64_mask(_mm512_and_si512(va, vb), va))
+            return false;
+    }
+    return true;
+}
+
+__attribute__((target("avx512f"))) static bool avx512Disjoint(const uint64_t *a, const uint64_t *b, size_t words)
+{
+    for (size_t i = 0; i < words; i += 8)
+    {
+        __mmask8 lanes = tailLanes(i, words);
+        __m512i va = _mm512_mask_loadu_epi64(_mm512_setzero_si512(), lanes, a + i);
+        __m512i vb = _mm512_mask_loadu_epi64(_mm512_setzero_si512(), lanes, b + i);
+        if (_mm512_test_epi64_mask(va, vb))
+            return false;
+    }
+    return true;
+}
+
+__attribute__((target("avx512f"))) static void avx512OrReduce(uint64_t *dst, const uint64_t *const *srcs, size_t n,
+                                                              size_t words)
+{
+    for (size_t i = 0; i < words; i += 8)
+    {
+        __mmask8 lanes = tailLanes(i, words);
+        __m512i acc = _mm512_mask_loadu_epi64(_mm512_setzero_si512(), lanes, dst + i);
+        for (size_t j = 0; j < n; j++)
+            acc = _mm512_or_si512(acc, _mm512_mask_loadu_epi64(_mm512_setzero_si512(), lanes, srcs[j] + i));
+        _mm512_mask_storeu_epi64(dst + i, lanes, acc);
+    }
+}
+
+static const maskKernelSet avx2Kernels = {"avx2", avx2Subset, avx2Disjoint, popcntAndCount, avx2OrReduce};
+static const maskKernelSet avx512Kernels = {"avx512", avx512Subset, avx512Disjoint, popcntAndCount, avx512OrReduce};
+#endif
+
+vector<const maskKernelSet *> supportedMaskKernels()
+{
+    vector<const maskKernelSet *> out = {&scalarKernels};
+#ifdef MASK_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        out.push_back(&avx2Kernels);
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt"))
+        out.push_back(&avx512Kernels);
+#endif
+    return out;
+}
+
+bool selectMaskKernels(const string &name)
+{
+    vector<const maskKernelSet *> supported = supportedMaskKernels();
+    for (size_t i = 0; i < supported.size(); i++)
+    {
+        if (name == supported[i]->name)
+        {
+            maskKernels = *supported[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+maskKernelSet maskKernels = *supportedMaskKernels().back();
@@ -8,8 +8,9 @@
 
 using namespace std;
 
+template <size_t W>
 molGraph constructFromEdgeList(molGraph &mg, vector<edgeL> &edgeList,
-                               standardBitset &mask, bool &isCyclic)
+                               standardBitset<W> &mask, bool &isCyclic)
 {
     disjointSet u(mg.mg.size());
     molGraph output;
@@ -65,7 +66,7 @@ molGraph constructFromEdgeList(molGraph &mg, vector<edgeL> &edgeList,
 
 molGraph preprocessWriteback(molGraph &mg, vector<edgeL> &writeback)
 {
-    std::unordered_map<string, pair<int, edgeL>> ht;
+    std::unordered_map<uint64_t, pair<int, edgeL>> ht;
     molGraph out = mg;
     mg.writeEdgeList(ht);
     vector<edgeL> v;
@@ -83,9 +84,74 @@ molGraph preprocessWriteback(molGraph &mg, vector<edgeL> &writeback)
 
 /// Global variable for the molGraph before and after preprocessing
 molGraph originalMolecule, targetMolecule;
+labelDictionary atomLabels;
 
-void ufdsMaskConstruct(standardBitset &mask,
-                       vector<standardBitset> &maskList)
+labelledGraph toLabelledGraph(molGraph &mg)
+{
+    labelledGraph g;
+    g.n = mg.mg.size();
+    g.type.resize(g.n);
+    g.start.resize(g.n + 1, 0);
+    for (int v = 0; v < g.n; v++)
+    {
+        g.type[v] = mg.mg[v].type;
+        for (size_t j = 0; j < mg.degree(v); j++)
+        {
+            g.nbr.push_back(mg.elem(v, j));
+            g.btype.push_back(mg.btypeS(v, j));
+        }
+        g.start[v + 1] = g.nbr.size();
+    }
+    return g;
+}
+
+template <size_t W>
+labelledGraph toLabelledGraph(molGraph &mg, const vector<edgeL> &edgeList, const standardBitset<W> &mask)
+{
+    labelledGraph g;
+    // Atoms of the subgraph are numbered as they are met, and each bond is entered at both of its ends
+    vi local(mg.mg.size(), -1), ends, btypes, atoms;
+    for (size_t i = 0; i < edgeList.size(); i++)
+    {
+        if (!mask[i])
+            continue;
+        for (int a : {int(edgeList[i].a), int(edgeList[i].b)})
+        {
+            if (local[a] < 0)
+            {
+                local[a] = atoms.size();
+                atoms.push_back(a);
+            }
+            ends.push_back(local[a]);
+        }
+        btypes.push_back(mg.btypeS(edgeList[i].a, edgeList[i].c));
+    }
+    g.n = atoms.size();
+    g.type.resize(g.n);
+    for (int v = 0; v < g.n; v++)
+        g.type[v] = mg.mg[atoms[v]].type;
+    g.start.assign(g.n + 1, 0);
+    for (int v : ends)
+        g.start[v + 1]++;
+    for (int v = 0; v < g.n; v++)
+        g.start[v + 1] += g.start[v];
+    g.nbr.resize(ends.size());
+    g.btype.resize(ends.size());
+    vi next(g.start.begin(), g.start.end() - 1);
+    for (size_t k = 0; k < btypes.size(); k++)
+    {
+        int a = ends[2 * k], b = ends[2 * k + 1];
+        g.nbr[next[a]] = b;
+        g.btype[next[a]++] = btypes[k];
+        g.nbr[next[b]] = a;
+        g.btype[next[b]++] = btypes[k];
+    }
+    return g;
+}
+
+template <size_t W>
+void ufdsMaskConstruct(standardBitset<W> &mask,
+                       vector<standardBitset<W>> &maskList)
 {
     vector<edgeL> &edgeList = univEdgeList;
     ufdsSplit u(targetMolecule.mg.size());
@@ -115,5 +181,12 @@ void ufdsMaskConstruct(standardBitset &mask,
             }
         }
     }
-    u.split(maskList);
-}
\ No newline at end of file
+    u.split<W>(maskList);
+}
+
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_MOLGRAPH(W) \
+    template molGraph constructFromEdgeList<W>(molGraph &, vector<edgeL> &, standardBitset<W> &, bool &); \
+    template labelledGraph toLabelledGraph<W>(molGraph &, const vector<edgeL> &, const standardBitset<W> &); \
+    template void ufdsMaskConstruct<W>(standardBitset<W> &, vector<standardBitset<W>> &);
+FOR_EACH_MASK_WIDTH(INSTANTIATE_MOLGRAPH)
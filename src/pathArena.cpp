@@ -0,0 +1,102 @@
+#include "pathArena.h"
+#include <algorithm>       // for copy, equal, max
+#include <cstddef>         // for size_t
+#include <mutex>           // for mutex, lock_guard
+#include <new>             // for placement new
+#include <vector>          // for vector
+#include "assemblyState.h" // for assemblyPath, pathPtr, stateKey
+
+using namespace std;
+
+/// Size of the slabs nodes are carved out of
+constexpr size_t SLAB_BYTES = size_t(1) << 18;
+
+/**
+ * @brief Bytes taken by a node with a key of keySize entries, rounded up to keep the nodes aligned
+ */
+static size_t blockBytes(size_t keySize)
+{
+    size_t bytes = sizeof(assemblyPath) + keySize * sizeof(int);
+    return (bytes + alignof(assemblyPath) - 1) / alignof(assemblyPath) * alignof(assemblyPath);
+}
+
+void retainPath(assemblyPath *ap)
+{
+    ap->refs.fetch_add(1, memory_order_relaxed);
+}
+
+void releasePath(assemblyPath *ap)
+{
+    if (ap->refs.fetch_sub(1, memory_order_acq_rel) == 1)
+        ap->arena->destroy(ap);
+}
+
+bool assemblyPath::hasKey(const stateKey &_key) const
+{
+    return keySize == _key.size() && equal(key, key + keySize, _key.data());
+}
+
+pathArena::~pathArena()
+{
+    reset();
+}
+
+assemblyPath *pathArena::create(const stateKey &key, int sumDupBonds, const pathPtr &parent,
+                                unsigned short match, unsigned short duplicate)
+{
+    char *block = nullptr;
+    {
+        lock_guard<mutex> guard(lock);
+        if (key.size() < freeBlocks.size() && freeBlocks[key.size()] != nullptr)
+        {
+            block = freeBlocks[key.size()];
+            freeBlocks[key.size()] = *reinterpret_cast<char **>(block);
+        }
+        else
+        {
+            size_t bytes = blockBytes(key.size());
+            if (next == nullptr || size_t(end - next) < bytes)
+            {
+                size_t slabBytes = max(SLAB_BYTES, bytes);
+                slabs.push_back(new char[slabBytes]);
+                next = slabs.back();
+                end = next + slabBytes;
+            }
+            block = next;
+            next += bytes;
+        }
+    }
+    assemblyPath *ap = new (block) assemblyPath;
+    ap->key = reinterpret_cast<int *>(block + sizeof(assemblyPath));
+    copy(key.data(), key.data() + key.size(), ap->key);
+    ap->keySize = key.size();
+    ap->sumDupBonds = sumDupBonds;
+    ap->match = match;
+    ap->duplicate = duplicate;
+    ap->arena = this;
+    ap->parent = parent;
+    return ap;
+}
+
+void pathArena::destroy(assemblyPath *ap)
+{
+    size_t keySize = ap->keySize;
+    // Releasing the parent may destroy nodes of this arena too, so it happens before taking the lock
+    ap->~assemblyPath();
+    char *block = reinterpret_cast<char *>(ap);
+    lock_guard<mutex> guard(lock);
+    if (freeBlocks.size() <= keySize)
+        freeBlocks.resize(keySize + 1, nullptr);
+    *reinterpret_cast<char **>(block) = freeBlocks[keySize];
+    freeBlocks[keySize] = block;
+}
+
+void pathArena::reset()
+{
+    lock_guard<mutex> guard(lock);
+    for (size_t i = 0; i < slabs.size(); i++)
+        delete[] slabs[i];
+    slabs.clear();
+    freeBlocks.clear();
+    next = end = nullptr;
+}
@@ -9,14 +9,16 @@
 #include <vector>             // for vector
 #include "assemblyState.h"    // for assemblyPath, minAssemblyPath
 #include "globalPrimitives.h" // for triple, standardBitset, univEdgeList
-#include "graphHashes.h"      // for graphHashMap
+#include "graphHashes.h"      // for graphHashMap, fragmentClass
+#include "maskPool.h"         // for fragmentPool, bitsetHashTable
 #include "molGraph.h"         // for atom, molGraph, originalMolecule, targ...
 
 using namespace std;
 
 vector<reconstructedState> minAssemblyPathway;
 
-void printMaskAsEdgeList(standardBitset mask, ofstream &ofs)
+template <size_t W>
+void printMaskAsEdgeList(standardBitset<W> mask, ofstream &ofs)
 {
     int msb;
     for (msb = univEdgeList.size() - 1; msb >= 0; msb--)
@@ -47,12 +49,13 @@ void printMaskAsEdgeList(ofstream &ofs)
     ofs << "]";
 }
 
-void printMatching(vector<standardBitset> &maskList, ofstream &ofs)
+template <size_t W>
+void printMatching(vector<standardBitset<W>> &maskList, ofstream &ofs)
 {
     ofs << "{\"Left\":";
-    printMaskAsEdgeList(maskList[0], ofs);
+    printMaskAsEdgeList<W>(maskList[0], ofs);
     ofs << ",\"Right\":";
-    printMaskAsEdgeList(maskList[1], ofs);
+    printMaskAsEdgeList<W>(maskList[1], ofs);
     ofs << "}";
 }
 
@@ -71,7 +74,7 @@ void printOriginalGraph(ofstream &ofs)
     ofs << "\"VertexColours\": [";
     for (size_t i = 0; i < originalMolecule.mg.size(); i++)
     {
-        ofs << "\"" << originalMolecule.mg[i].type << "\"";
+        ofs << "\"" << originalMolecule.atype(i) << "\"";
         if (i < originalMolecule.mg.size() - 1) ofs << ',';
     }
     ofs << "],\n";
@@ -106,9 +109,10 @@ void printOriginalGraph(ofstream &ofs)
     ofs << "]\n";
 }
 
-void printRemnantGraph(standardBitset mask, ofstream &ofs)
+template <size_t W>
+void printRemnantGraph(standardBitset<W> mask, ofstream &ofs)
 {
-    standardBitset dual = allEdges ^ mask, remnantAtoms = 0;
+    standardBitset<W> dual = allEdges<W> ^ mask, remnantAtoms = 0;
     int msb, msb2;
     for (msb = univEdgeList.size() - 1; msb >= 0; msb--)
         if (dual[msb])
@@ -117,7 +121,7 @@ void printRemnantGraph(standardBitset mask, ofstream &ofs)
     {
         if (dual[i])
         {
-            standardBitset b1, b2;
+            standardBitset<W> b1, b2;
             b1.set(univEdgeList[i].a), b2.set(univEdgeList[i].b);
             remnantAtoms |= (b1 | b2);
         }
@@ -137,14 +141,14 @@ void printRemnantGraph(standardBitset mask, ofstream &ofs)
     }
     ofs << "],\n";
     ofs << "\"Edges\": ";
-    printMaskAsEdgeList(dual, ofs);
+    printMaskAsEdgeList<W>(dual, ofs);
     ofs << ",\n";
     ofs << "\"VertexColours\": [";
     for (size_t i = 0; i < targetMolecule.mg.size(); i++)
     {
         if (remnantAtoms[i])
         {
-            ofs << "\"" << targetMolecule.mg[i].type << "\"";
+            ofs << "\"" << targetMolecule.atype(i) << "\"";
             if (i != msb2)
                 ofs << ',';
         }
@@ -184,17 +188,18 @@ void printRemnantGraph(standardBitset mask, ofstream &ofs)
     ofs << "]\n";
 }
 
+template <size_t W>
 void recoverPathway2(vector<edgeL> &removedEdges)
 {
     minAssemblyPathway.clear();
     assemblyPath *curr, *prev;
     stack<assemblyPath *> sap;
-    sap.push(minAssemblyPath);
+    sap.push(minAssemblyPath.get());
     vector<assemblyPath *> minPath;
     curr = sap.top();
     while (curr != nullptr)
     {
-        prev = curr->parent;
+        prev = curr->parent.get();
         sap.push(prev);
         curr = prev;
     }
@@ -204,21 +209,24 @@ void recoverPathway2(vector<edgeL> &removedEdges)
         minPath.push_back(sap.top());
         sap.pop();
     }
-    vector<vector<standardBitset>> maskList(graphHashMap.size());
-    for (auto it = graphHashMap.begin(); it != graphHashMap.end(); ++it)
+    vector<vector<standardBitset<W>>> maskList(graphHashMap<W>.size());
+    for (auto it = graphHashMap<W>.buckets.begin(); it != graphHashMap<W>.buckets.end(); ++it)
     {
-        maskList[it->second.first].resize(it->second.second + 1);
+        for (const fragmentClass<W> &cls : it->second)
+            maskList[cls.value.first].resize(cls.value.second + 1);
     }
-    for (auto it = bitsetHashTable.begin(); it != bitsetHashTable.end(); ++it)
+    for (maskId id = 0; id < bitsetHashTable<W>.idLimit(); id++)
     {
-        maskList[it->second.first][it->second.second] = it->first;
+        pii value;
+        if (bitsetHashTable<W>.find(id, value))
+            maskList[value.first][value.second] = fragmentPool<W>[id];
     }
-    standardBitset allTakenEdges = 0;
-    vector<reconstructedEdgelist> v;
+    standardBitset<W> allTakenEdges = 0;
+    vector<reconstructedEdgelist<W>> v;
     for (size_t i = 1; i < minPath.size(); i++)
     {
-        reconstructedEdgelist r;
-        standardBitset mask = maskList[minPath[i]->key[0]][minPath[i]->match],
+        reconstructedEdgelist<W> r;
+        standardBitset<W> mask = maskList[minPath[i]->key[0]][minPath[i]->match],
                        duplicate = maskList[minPath[i]->key[0]][minPath[i]->duplicate];
         allTakenEdges |= duplicate;
         r.list.push_back(mask);
@@ -234,13 +242,13 @@ void recoverPathway2(vector<edgeL> &removedEdges)
     ofs << "],\n";
     ofs << "\"remnant\":[\n";
     ofs << "{\n";
-    printRemnantGraph(allTakenEdges, ofs);
+    printRemnantGraph<W>(allTakenEdges, ofs);
     ofs << "}\n";
     ofs << "],\n";
     ofs << "\"duplicates\":[\n";
     for (size_t i = 0; i < v.size(); i++)
     {
-        printMatching(v[i].list, ofs);
+        printMatching<W>(v[i].list, ofs);
         if (i < v.size() - 1)
             ofs << ",\n";
     }
@@ -254,4 +262,8 @@ void recoverPathway2(vector<edgeL> &removedEdges)
     }
     ofs << "]\n";
     ofs << "}\n";
-}
\ No newline at end of file
+}
+
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_PATHWAY_GENERATOR(W) template void recoverPathway2<W>(vector<edgeL> &);
+FOR_EACH_MASK_WIDTH(INSTANTIATE_PATHWAY_GENERATOR)
@@ -0,0 +1,45 @@
+#include "searchBounds.h"
+#include <atomic> // for atomic
+#include <memory> // for unique_ptr
+
+using namespace std;
+
+searchBounds openBounds;
+
+void searchBounds::reset(int maxBound)
+{
+    range = maxBound + 1;
+    open.reset(new atomic<long long>[range]);
+    for (int i = 0; i < range; i++)
+        open[i] = 0;
+    reported = 0;
+}
+
+int searchBounds::slot(int bound)
+{
+    if (bound < 0)
+        return 0;
+    if (bound >= range)
+        return range - 1;
+    return bound;
+}
+
+void searchBounds::openBound(int bound)
+{
+    open[slot(bound)]++;
+}
+
+void searchBounds::closeBound(int bound)
+{
+    open[slot(bound)]--;
+}
+
+int searchBounds::lowerBound(int incumbent)
+{
+    for (int i = 0; i < range && i < incumbent; i++)
+    {
+        if (open[i] > 0)
+            return i;
+    }
+    return incumbent;
+}
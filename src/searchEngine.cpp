@@ -0,0 +1,122 @@
+#include "searchEngine.h"
+#include <algorithm>          // for stable_sort
+#include <atomic>             // for atomic
+#include <utility>            // for move
+#include <vector>             // for vector
+#include "globalPrimitives.h" // for interruptFlag, branchOrder
+#include "improvedBnB.h"      // for generateChildren, fragmentChild, claimAssemblyState, closeSearchBound
+#include "searchBounds.h"     // for openBounds
+#include "workStealingPool.h" // for searchPool
+
+using namespace std;
+
+template <size_t W>
+searchEngine<W>::searchEngine(assemblyState<W> &root, int bound, atomic<int> &_AI) : AI(_AI)
+{
+    stack.emplace_back(root);
+    stack.back().bound = bound;
+}
+
+template <size_t W>
+bool searchEngine<W>::run(size_t maxNodes)
+{
+    size_t budget = maxNodes;
+    while (!stack.empty())
+    {
+        if (interruptFlag)
+            return false;
+        searchFrame<W> &f = stack.back();
+        if (!f.expanded)
+        {
+            if (maxNodes != 0 && budget == 0)
+                return false;
+            budget--;
+            nodes++;
+            f.expanded = 1;
+            generateChildren(f.state, AI, f.children, f.sets);
+            if (branchOrder)
+                stable_sort(f.children.begin(), f.children.end(), compareRankedChild());
+            // The children take the place of the state. They are opened first so that the proven lower bound never
+            // passes them, and an interrupted expansion leaves the state open as it may be missing children
+            for (size_t i = 0; i < f.children.size(); i++)
+                openBounds.openBound(f.children[i].bound);
+            if (!interruptFlag)
+                closeSearchBound(f.bound, AI);
+            continue;
+        }
+        if (f.next == f.children.size())
+        {
+            stack.pop_back();
+            continue;
+        }
+        rankedChild<W> &c = f.children[f.next++];
+        // Children are only fragmented and claimed when their turn comes, as the incumbent may have reached their
+        // bound by then. A fragmented child is held open by its own bound in place of that of its duplicate set
+        assemblyState<W> child;
+        int setBound = c.bound;
+        if (c.bound < AI && fragmentChild(f.state, c, f.sets[c.set], child) != setBound)
+        {
+            openBounds.openBound(c.bound);
+            closeSearchBound(setBound, AI);
+        }
+        if (c.bound >= AI || !claimAssemblyState(f.state, child, c.matching))
+        {
+            closeSearchBound(c.bound, AI);
+            continue;
+        }
+        // Hand the subtree to an idle worker if running in parallel, which closes its bound, otherwise search it here
+        if (searchPool<W> != nullptr && searchPool<W>->trySpawn(child, c.bound))
+            continue;
+        int bound = c.bound;
+        stack.emplace_back();
+        stack.back().state = move(child);
+        stack.back().bound = bound;
+    }
+    return true;
+}
+
+template <size_t W>
+void searchEngine<W>::resume(vector<searchFrame<W>> &saved)
+{
+    int rootBound = stack[0].bound;
+    stack.swap(saved);
+    // The checkpoint does not keep the bound of a frame, which is that of the child it was pushed from
+    for (size_t i = 0; i < stack.size(); i++)
+    {
+        searchFrame<W> &f = stack[i];
+        if (i == 0)
+            f.bound = rootBound;
+        else if (stack[i - 1].next > 0)
+            f.bound = stack[i - 1].children[stack[i - 1].next - 1].bound;
+        if (!f.expanded)
+            openBounds.openBound(f.bound);
+        else
+        {
+            for (size_t j = f.next; j < f.children.size(); j++)
+                openBounds.openBound(f.children[j].bound);
+        }
+    }
+    // The root was opened with the rest of the frontier, and the stack now stands in for it
+    openBounds.closeBound(rootBound);
+}
+
+template <size_t W>
+void searchEngine<W>::prune()
+{
+    for (size_t i = 0; i < stack.size(); i++)
+    {
+        searchFrame<W> &f = stack[i];
+        if (!f.expanded)
+            closeSearchBound(f.bound, AI);
+        else
+        {
+            for (size_t j = f.next; j < f.children.size(); j++)
+                closeSearchBound(f.children[j].bound, AI);
+        }
+    }
+    stack.clear();
+}
+
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_SEARCH_ENGINE(W) template struct searchEngine<W>;
+FOR_EACH_MASK_WIDTH(INSTANTIATE_SEARCH_ENGINE)
@@ -1,18 +1,41 @@
+#include <atomic>             // std::atomic
 #include <iostream>           // std::cout
-#include <cstdlib>            // std::exit
-#include "globalPrimitives.h" // minAIfound, interruptFlag, removedEdges
+#include <string>             // std::string, std::to_string
+#include "assemblyState.h"    // minAssemblyPath
+#include "globalPrimitives.h" // minAIfound, aiOffset, MAX_INT, interruptFlag, removedEdges, maskWidth
 #include "pathwayGenerator.h" // recoverPathway2 (if declared separately)
+#include "searchBounds.h"     // openBounds
 #include "signalHandler.h"
+#ifndef _WIN32
+#include <unistd.h>           // _exit
+#endif
 
 using namespace std;
 
+// The handlers store to interruptFlag, which is only safe in a signal handler if the atomic is lock-free
+static_assert(atomic<bool>::is_always_lock_free, "interruptFlag must be lock-free");
+
+/// Smallest assembly index found, offset as in the result file
+static string reportedAI()
+{
+    return minAIfound < 0 ? "none" : to_string(minAIfound - aiOffset);
+}
+
+/// Proven lower bound, offset as in the result file. Before a pathway is found nothing caps the open bounds
+static string reportedLowerBound()
+{
+    int lowerBound = openBounds.lowerBound(minAIfound < 0 ? MAX_INT : minAIfound);
+    return lowerBound == MAX_INT ? "none" : to_string(lowerBound - aiOffset);
+}
+
 #ifdef _WIN32
 BOOL CtrlHandler(DWORD fdwCtrlType)
 {
     switch (fdwCtrlType)
     {
     case CTRL_C_EVENT:
-        cout << "min AI found so far: " << minAIfound << '\n';
+        cout << "min AI found so far: " << reportedAI() << '\n';
+        cout << "proven lower bound: " << reportedLowerBound() << '\n';
         interruptFlag = true;
         return TRUE;
 
@@ -23,8 +46,15 @@ BOOL CtrlHandler(DWORD fdwCtrlType)
 #else
 void signalHandler(int signum)
 {
-    cout << "Interrupt signal received. Lowest AI found: " << minAIfound << '\n';
-    recoverPathway2(removedEdges);
-    exit(signum);
+    cout << "Interrupt signal received. Lowest AI found: " << reportedAI() << '\n';
+    cout << "Proven lower bound: " << reportedLowerBound() << '\n';
+    // A decision query has no pathway until one at or below the threshold is found
+    if (minAssemblyPath != nullptr)
+        dispatchMaskWidth(maskWidth, [](auto width)
+                          { recoverPathway2<decltype(width)::value>(removedEdges); });
+    // The search is stopped mid-flight, so the destructors of the global tables that exit would run can meet
+    // references into them that are still live. Flush what has been printed and leave without them
+    cout << flush;
+    _exit(signum);
 }
 #endif
\ No newline at end of file
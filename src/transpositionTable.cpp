@@ -0,0 +1,210 @@
+#include "transpositionTable.h"
+#include <cstddef>         // for size_t
+#include <mutex>           // for mutex, lock_guard
+#include <vector>          // for vector
+#include "assemblyState.h" // for assemblyPath, pathPtr, stateKey, retainPath, releasePath
+#include "pathArena.h"     // for pathArena
+
+using namespace std;
+
+/// Initial number of slots in each shard
+constexpr size_t SHARD_INITIAL_SLOTS = 16;
+/// Number of occupied slots the eviction sweep compares
+constexpr size_t EVICTION_SAMPLE = 8;
+
+/**
+ * @brief Approximate memory of an entry: the node with its key, and two slots, as the slot array is between 3/8 and
+ * 3/4 full
+ */
+static size_t entryBytes(const assemblyPath &ap)
+{
+    return sizeof(assemblyPath) + ap.keySize * sizeof(int) + 2 * sizeof(ttSlot);
+}
+
+transpositionTable pathAssemblyMap;
+transpositionTable diveMap;
+
+void transpositionTable::grow(ttShard &s)
+{
+    size_t newSize = s.slots.empty() ? SHARD_INITIAL_SLOTS : s.slots.size() * 2;
+    vector<ttSlot> newSlots(newSize);
+    size_t mask = newSize - 1;
+    for (size_t i = 0; i < s.slots.size(); i++)
+    {
+        if (s.slots[i].ap == nullptr)
+            continue;
+        size_t j = s.slots[i].hash & mask;
+        while (newSlots[j].ap != nullptr)
+            j = (j + 1) & mask;
+        newSlots[j] = s.slots[i];
+    }
+    s.slots.swap(newSlots);
+}
+
+void transpositionTable::erase(ttShard &s, size_t i)
+{
+    releasePath(s.slots[i].ap);
+    size_t mask = s.slots.size() - 1, j = i;
+    while (true)
+    {
+        j = (j + 1) & mask;
+        if (s.slots[j].ap == nullptr)
+            break;
+        // The entry in j may move to i if its home slot is not cyclically within (i, j]
+        size_t home = s.slots[j].hash & mask;
+        bool between = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+        if (!between)
+        {
+            s.slots[i] = s.slots[j];
+            i = j;
+        }
+    }
+    s.slots[i] = ttSlot();
+    s.used--;
+}
+
+void transpositionTable::evict(ttShard &s)
+{
+    size_t mask = s.slots.size() - 1, victim = s.slots.size();
+    bool victimFree = 0;
+    int victimDepth = -1;
+    for (size_t seen = 0, k = 0; seen < EVICTION_SAMPLE && k < s.slots.size(); k++)
+    {
+        size_t i = s.hand;
+        s.hand = (s.hand + 1) & mask;
+        if (s.slots[i].ap == nullptr)
+            continue;
+        seen++;
+        // Nodes only the table refers to free their memory when evicted. Among those, the deepest states have the
+        // smallest subtrees, so they are the cheapest to search again. Nodes on the incumbent pathway or still in
+        // use by the search are referred to elsewhere and only go if nothing else is available
+        bool free = s.slots[i].ap->refs == 1;
+        int depth = s.slots[i].ap->sumDupBonds;
+        if (victim == s.slots.size() || free > victimFree || (free == victimFree && depth > victimDepth))
+        {
+            victim = i;
+            victimFree = free;
+            victimDepth = depth;
+        }
+    }
+    if (victim == s.slots.size())
+        return;
+    s.bytes -= entryBytes(*s.slots[victim].ap);
+    erase(s, victim);
+    evictions++;
+}
+
+pathPtr transpositionTable::tryClaim(const stateKey &key, int sumDupBonds, const pathPtr &parent,
+                                     unsigned short match, unsigned short duplicate)
+{
+    size_t h = key.fingerprint();
+    ttShard &s = shards[h >> (sizeof(size_t) * 8 - SHARD_BITS)];
+    lock_guard<mutex> lock(s.lock);
+    if (!s.slots.empty())
+    {
+        size_t mask = s.slots.size() - 1, i = h & mask;
+        while (s.slots[i].ap != nullptr)
+        {
+            ttSlot &slot = s.slots[i];
+            if (slot.hash == h && slot.ap->hasKey(key))
+            {
+                if (sumDupBonds <= slot.ap->sumDupBonds)
+                    return nullptr;
+                slot.ap->sumDupBonds = sumDupBonds;
+                slot.ap->match = match;
+                slot.ap->duplicate = duplicate;
+                slot.ap->parent = parent;
+                return pathPtr(slot.ap);
+            }
+            i = (i + 1) & mask;
+        }
+    }
+    // The node is only built once the key is known to be new
+    pathPtr ap(s.arena.create(key, sumDupBonds, parent, match, duplicate));
+    size_t bytes = entryBytes(*ap);
+    while (shardBudget != 0 && s.used > 0 && s.bytes + bytes > shardBudget)
+        evict(s);
+    // Keep the load factor below 3/4
+    if (4 * (s.used + 1) > 3 * s.slots.size())
+        grow(s);
+    size_t mask = s.slots.size() - 1, i = h & mask;
+    while (s.slots[i].ap != nullptr)
+        i = (i + 1) & mask;
+    s.slots[i].hash = h;
+    s.slots[i].ap = ap.get();
+    retainPath(ap.get());
+    s.used++;
+    s.bytes += bytes;
+    return ap;
+}
+
+pathPtr transpositionTable::find(const stateKey &key)
+{
+    size_t h = key.fingerprint();
+    ttShard &s = shards[h >> (sizeof(size_t) * 8 - SHARD_BITS)];
+    lock_guard<mutex> lock(s.lock);
+    if (s.slots.empty())
+        return nullptr;
+    size_t mask = s.slots.size() - 1, i = h & mask;
+    while (s.slots[i].ap != nullptr)
+    {
+        if (s.slots[i].hash == h && s.slots[i].ap->hasKey(key))
+            return pathPtr(s.slots[i].ap);
+        i = (i + 1) & mask;
+    }
+    return nullptr;
+}
+
+pathPtr transpositionTable::makeNode(const stateKey &key, int sumDupBonds, const pathPtr &parent,
+                                     unsigned short match, unsigned short duplicate)
+{
+    size_t h = key.fingerprint();
+    ttShard &s = shards[h >> (sizeof(size_t) * 8 - SHARD_BITS)];
+    return pathPtr(s.arena.create(key, sumDupBonds, parent, match, duplicate));
+}
+
+vector<pathPtr> transpositionTable::nodes()
+{
+    vector<pathPtr> result;
+    for (size_t k = 0; k < SHARDS; k++)
+    {
+        for (size_t i = 0; i < shards[k].slots.size(); i++)
+        {
+            if (shards[k].slots[i].ap != nullptr)
+                result.emplace_back(shards[k].slots[i].ap);
+        }
+    }
+    return result;
+}
+
+void transpositionTable::setMemoryLimit(size_t bytes)
+{
+    shardBudget = bytes / SHARDS;
+}
+
+size_t transpositionTable::size()
+{
+    size_t total = 0;
+    for (size_t k = 0; k < SHARDS; k++)
+    {
+        lock_guard<mutex> lock(shards[k].lock);
+        total += shards[k].used;
+    }
+    return total;
+}
+
+void transpositionTable::clear()
+{
+    for (size_t k = 0; k < SHARDS; k++)
+    {
+        ttShard &s = shards[k];
+        lock_guard<mutex> lock(s.lock);
+        // Every node lives in the arena, so the slots are dropped without releasing them one by one
+        s.slots.clear();
+        s.arena.reset();
+        s.used = 0;
+        s.bytes = 0;
+        s.hand = 0;
+    }
+    evictions = 0;
+}
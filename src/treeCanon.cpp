@@ -1,112 +1,172 @@
 #include "treeCanon.h"
-#include <algorithm>          // for sort, max
-#include <cstddef>            // for size_t, std
-#include <string>             // for allocator, basic_string, char_traits
+#include <algorithm>          // for sort, equal, max, min
+#include <cstddef>            // for size_t
+#include <cstdint>            // for uint32_t, uint64_t, UINT32_MAX
 #include <vector>             // for vector
-#include "globalPrimitives.h" // for pii
-#include "molGraph.h"         // for bond, atom, molGraph
+#include "globalPrimitives.h" // for vi
+#include "molGraph.h"         // for labelledGraph
 
 using namespace std;
 
-string treeCanonRecursive(molGraph &mg, int curr, int parent, char type)
+/// First entry of the encoding of a tree with two centroids, which no atom type code takes
+constexpr uint32_t BICENTROID = UINT32_MAX;
+
+/**
+ * @brief Numbers of the subtrees met so far, by their encodings: the atom type of the root, then the bond type and
+ * number of each subtree below the root, in order. The encodings are stored one after the other in one array, and
+ * found through an open addressing table of their numbers, so looking one up allocates nothing. The scratch space
+ * of treeCanonKey is kept here too, under the same lock as the table
+ */
+struct subtreeTable
 {
-    string atomName(mg.mg[curr].type), bondName;
-    if (atomName == "X")
-        return "";
-    if (parent != -1)
-        bondName = type;
-    else
-        bondName = "$";
-    string name = "(" + bondName + atomName;
+    /// @brief the encoding numbered k is words[begin[k]] to words[begin[k + 1] - 1]
+    vector<uint32_t> words, begin{0};
+    /// @brief hash of each encoding
+    vector<uint64_t> hashes;
+    /// @brief number + 1 of the encoding in each slot, 0 for an empty slot. The size is a power of two
+    vector<uint32_t> slots = vector<uint32_t>(1024, 0);
+    /// @brief scratch space of treeCanonKey
+    vi order, parent, size, numbers;
+    vector<uint64_t> below;
+    vector<uint32_t> encoding;
 
-    if (mg.degree(curr) == 0)
+    static uint64_t hash(const vector<uint32_t> &encoding)
     {
-        name += ')';
-        return name;
+        // FNV-1a, then the splitmix64 finaliser to spread the bits used for the slot
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (uint32_t x : encoding)
+            h = (h ^ x) * 0x100000001b3ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
     }
-    vector<string> stringArray;
-    vector<bond> &v = mg.mg[curr].list;
-    for (size_t i = 0; i < v.size(); i++)
+
+    uint32_t number(const vector<uint32_t> &encoding)
     {
-        if (v[i].n != parent)
-            stringArray.push_back(treeCanonRecursive(mg, v[i].n, curr, v[i].type));
+        uint64_t h = hash(encoding);
+        size_t mask = slots.size() - 1, slot = h & mask;
+        for (; slots[slot] != 0; slot = (slot + 1) & mask)
+        {
+            uint32_t k = slots[slot] - 1;
+            if (hashes[k] == h && begin[k + 1] - begin[k] == encoding.size() &&
+                equal(encoding.begin(), encoding.end(), words.begin() + begin[k]))
+                return k;
+        }
+        uint32_t k = hashes.size();
+        words.insert(words.end(), encoding.begin(), encoding.end());
+        begin.push_back(words.size());
+        hashes.push_back(h);
+        slots[slot] = k + 1;
+        if (2 * hashes.size() > slots.size())
+            grow();
+        return k;
     }
-    sort(stringArray.begin(), stringArray.end());
-    for (unsigned int i = 0; i < stringArray.size(); i++)
-        name += stringArray[i];
-    name += ')';
-    return name;
-}
 
-int centroidDFS(molGraph &mg, vector<int> &weight, int curr, int prev)
-{
-    if (mg.mg[curr].type == "X")
-        return 0;
-    vector<bond> &v = mg.mg[curr].list;
-    for (size_t i = 0; i < v.size(); i++)
+    /// @brief Doubles the slots, keeping the table at most half full
+    void grow()
     {
-        if (v[i].n != prev)
-            weight[curr] += centroidDFS(mg, weight, v[i].n, curr);
+        slots.assign(2 * slots.size(), 0);
+        size_t mask = slots.size() - 1;
+        for (uint32_t k = 0; k < hashes.size(); k++)
+        {
+            size_t slot = hashes[k] & mask;
+            while (slots[slot] != 0)
+                slot = (slot + 1) & mask;
+            slots[slot] = k + 1;
+        }
     }
-    return weight[curr];
+};
+
+static subtreeTable subtrees;
+
+void clearTreeCanon()
+{
+    subtrees = subtreeTable();
 }
 
-pii centroid(molGraph &mg, int currRoot)
+/**
+ * @brief Breadth first order of the vertices from root, so that every vertex comes after its parent, and the parent
+ * of each vertex, -1 for the root
+ */
+static void breadthFirst(const labelledGraph &g, int root, vi &order, vi &parent)
 {
-    float size = mg.mg.size() + 0.0;
-    vector<bool> visited((int)size, 0);
-    vector<int> weight((int)size, 1);
-    bool isCentroid = 0;
-    int prevRoot = -1;
-    centroidDFS(mg, weight, currRoot, -1);
-    bool has2Centroids = 0;
-    while (!isCentroid)
+    order.assign(1, root);
+    parent.assign(g.n, -2);
+    parent[root] = -1;
+    for (size_t i = 0; i < order.size(); i++)
     {
-        vector<bond> &v = mg.mg[currRoot].list;
-        bool overweight = 0;
-        short j = currRoot;
-        for (size_t i = 0; i < v.size(); i++)
+        int v = order[i];
+        for (int k = g.start[v]; k < g.start[v + 1]; k++)
         {
-            j = v[i].n;
-            if (j != prevRoot && weight[j] >= size / 2)
+            if (parent[g.nbr[k]] == -2)
             {
-                if (weight[j] == size / 2)
-                {
-                    has2Centroids = 1;
-                }
-                overweight = 1;
-                break;
+                parent[g.nbr[k]] = v;
+                order.push_back(g.nbr[k]);
             }
         }
-        if (!overweight)
-            isCentroid = 1;
-        else
-        {
-            prevRoot = currRoot;
-            currRoot = j;
-        }
     }
-    pii p(currRoot, -1);
-    if (has2Centroids)
-        p.second = prevRoot;
-    return p;
 }
 
-string centroidTreeCanon(molGraph &mg, int n)
+uint32_t treeCanonKey(const labelledGraph &g)
 {
-    if (mg.mg.size() == 0)
-        return "";
-    string canonicalForm;
-    pii centroids = centroid(mg, n);
-    vector<string> stringArray(2, "");
-    stringArray[0] = treeCanonRecursive(mg, centroids.first, -1, ' ');
-    if (centroids.second != -1)
+    vi &order = subtrees.order, &parent = subtrees.parent, &size = subtrees.size, &numbers = subtrees.numbers;
+    vector<uint64_t> &below = subtrees.below;
+    vector<uint32_t> &encoding = subtrees.encoding;
+    encoding.clear();
+    if (g.n == 0)
+        return subtrees.number(encoding);
+    size.assign(g.n, 1);
+    breadthFirst(g, 0, order, parent);
+    int n = order.size();
+    for (int i = n - 1; i > 0; i--)
+        size[parent[order[i]]] += size[order[i]];
+    // The centroids are the vertices whose removal leaves no component of more than half the vertices. There are
+    // one or two, and two are bonded
+    int root = -1, other = -1;
+    for (int v : order)
+    {
+        int largest = n - size[v];
+        for (int k = g.start[v]; k < g.start[v + 1]; k++)
+        {
+            if (g.nbr[k] != parent[v])
+                largest = max(largest, size[g.nbr[k]]);
+        }
+        if (2 * largest <= n)
+            (root < 0 ? root : other) = v;
+    }
+
+    // Number the subtrees from the leaves up. With two centroids the root leaves out the half of the other
+    breadthFirst(g, root, order, parent);
+    numbers.resize(g.n);
+    uint32_t centralBond = 0;
+    for (int i = n - 1; i >= 0; i--)
     {
-        stringArray[1] = treeCanonRecursive(mg, centroids.second, -1, ' ');
-        sort(stringArray.begin(), stringArray.end());
-        canonicalForm = stringArray[0] + stringArray[1];
+        int v = order[i];
+        below.clear();
+        for (int k = g.start[v]; k < g.start[v + 1]; k++)
+        {
+            int u = g.nbr[k];
+            if (u == parent[v])
+                continue;
+            if (v == root && u == other)
+            {
+                centralBond = g.btype[k];
+                continue;
+            }
+            below.push_back(uint64_t(uint32_t(g.btype[k])) << 32 | uint32_t(numbers[u]));
+        }
+        sort(below.begin(), below.end());
+        encoding.assign(1, uint32_t(g.type[v]));
+        for (uint64_t b : below)
+        {
+            encoding.push_back(uint32_t(b >> 32));
+            encoding.push_back(uint32_t(b));
+        }
+        numbers[v] = subtrees.number(encoding);
     }
-    else
-        canonicalForm = stringArray[0];
-    return canonicalForm;
+    if (other < 0)
+        return numbers[root];
+    uint32_t a = numbers[root], b = numbers[other];
+    encoding.assign({BICENTROID, centralBond, min(a, b), max(a, b)});
+    return subtrees.number(encoding);
 }
@@ -1,19 +1,19 @@
 #include "vf2.h"
-#include <algorithm>                             // for copy
+#include <algorithm>                             // for copy, sort, equal_range
 #include <boost/graph/adjacency_list.hpp>        // for target, source
 #include <boost/graph/vf2_sub_graph_iso.hpp>     // for vertex_order_by_mult
 #include <cstddef>                               // for size_t, std
 #include <list>                                  // for operator==
 #include <map>                                   // for operator==
-#include <string>                                // for string
 #include <unordered_map>                         // for unordered_map
+#include <vector>                                // for vector
 #include "boost/graph/detail/adjacency_list.hpp" // for in_degree, out_degree
 #include "boost/graph/detail/edge.hpp"           // for operator<, operator!=
 #include "boost/graph/named_function_params.hpp" // for bgl_named_params
 #include "boost/property_map/property_map.hpp"   // for get, put
 #include "boost/tuple/detail/tuple_basic.hpp"    // for get
 #include "globalPrimitives.h"                    // for triple, edgeL, stan...
-#include "molGraph.h"                            // for atom, molGraph
+#include "molGraph.h"                            // for atom, molGraph, labelledGraph
 
 using namespace std;
 
@@ -30,7 +30,8 @@ struct halting_callback
     }
 };
 
-molGraphBoost edgelistToBoost(molGraph &mg, vector<edgeL> &edgeList, const standardBitset &mask)
+template <size_t W>
+molGraphBoost edgelistToBoost(molGraph &mg, vector<edgeL> &edgeList, const standardBitset<W> &mask)
 {
     molGraphBoost output;
     std::unordered_map<int, int> ht;
@@ -43,15 +44,13 @@ molGraphBoost edgelistToBoost(molGraph &mg, vector<edgeL> &edgeList, const stand
             {
                 size_t x = ht.size();
                 ht[a] = x;
-                string c = mg.mg[a].type;
-                add_vertex(atom_vf2(c), output);
+                add_vertex(atom_vf2(mg.mg[a].type), output);
             }
             if (ht.count(b) == 0)
             {
                 size_t x = ht.size();
                 ht[b] = x;
-                string c = mg.mg[b].type;
-                add_vertex(atom_vf2(c), output);
+                add_vertex(atom_vf2(mg.mg[b].type), output);
             }
             int a2 = ht[a], b2 = ht[b];
             add_edge(a2, b2, mg.btype(a, edgeList[i].c), output);
@@ -60,6 +59,11 @@ molGraphBoost edgelistToBoost(molGraph &mg, vector<edgeL> &edgeList, const stand
     return output;
 }
 
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_VF2(W) \
+    template molGraphBoost edgelistToBoost<W>(molGraph &, vector<edgeL> &, const standardBitset<W> &);
+FOR_EACH_MASK_WIDTH(INSTANTIATE_VF2)
+
 bool vf2GraphIso(molGraphBoost &mmg, molGraphBoost &tmg)
 {
     vertex_comp_t vc =
@@ -68,4 +72,138 @@ bool vf2GraphIso(molGraphBoost &mmg, molGraphBoost &tmg)
         boost::make_property_map_equivalent(get(boost::edge_name, mmg), get(boost::edge_name, tmg));
     halting_callback callback;
     return vf2_graph_iso(mmg, tmg, callback, vertex_order_by_mult(mmg), edges_equivalent(ec).vertices_equivalent(vc));
-}
\ No newline at end of file
+}
+
+/**
+ * @brief State of one native vf2 match of g1 onto g2
+ */
+struct vf2State
+{
+    const labelledGraph &g1, &g2;
+    /// @brief vertices of g1 in matching order, and for each the position in order of a neighbour matched before it,
+    /// -1 for the first vertex of a component
+    vi order, parent;
+    /// @brief the vertex each vertex is matched to, -1 while unmatched
+    vi core1, core2;
+
+    vf2State(const labelledGraph &_g1, const labelledGraph &_g2)
+        : g1(_g1), g2(_g2), core1(_g1.n, -1), core2(_g2.n, -1) {}
+
+    /**
+     * @brief Breadth first order of g1, each component started from a vertex whose atom type and degree are rarest
+     *
+     * @param rarity Number of vertices of g1 with the atom type and degree of each vertex
+     */
+    void orderVertices(const vi &rarity)
+    {
+        vb seen(g1.n, 0);
+        order.reserve(g1.n);
+        parent.reserve(g1.n);
+        while (order.size() < size_t(g1.n))
+        {
+            int root = -1;
+            for (int v = 0; v < g1.n; v++)
+            {
+                if (!seen[v] && (root < 0 || rarity[v] < rarity[root] ||
+                                 (rarity[v] == rarity[root] && g1.degree(v) > g1.degree(root))))
+                    root = v;
+            }
+            seen[root] = 1;
+            order.push_back(root);
+            parent.push_back(-1);
+            for (size_t i = order.size() - 1; i < order.size(); i++)
+            {
+                for (int k = g1.start[order[i]]; k < g1.start[order[i] + 1]; k++)
+                {
+                    int u = g1.nbr[k];
+                    if (seen[u])
+                        continue;
+                    seen[u] = 1;
+                    order.push_back(u);
+                    parent.push_back(i);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Whether v1 can be matched to v2 given the vertices matched so far
+     */
+    bool feasible(int v1, int v2) const
+    {
+        if (core2[v2] >= 0 || g1.type[v1] != g2.type[v2] || g1.degree(v1) != g2.degree(v2))
+            return false;
+        int matched = 0;
+        for (int k = g1.start[v1]; k < g1.start[v1 + 1]; k++)
+        {
+            int u2 = core1[g1.nbr[k]];
+            if (u2 < 0)
+                continue;
+            matched++;
+            // The image of a matched neighbour must be a neighbour of v2 through the same bond type
+            bool bonded = false;
+            for (int j = g2.start[v2]; j < g2.start[v2 + 1] && !bonded; j++)
+                bonded = g2.nbr[j] == u2 && g2.btype[j] == g1.btype[k];
+            if (!bonded)
+                return false;
+        }
+        // and v2 may have no other matched neighbours
+        for (int j = g2.start[v2]; j < g2.start[v2 + 1]; j++)
+            matched -= core2[g2.nbr[j]] >= 0;
+        return matched == 0;
+    }
+
+    bool match(size_t d)
+    {
+        if (d == order.size())
+            return true;
+        int v1 = order[d];
+        // Candidates are the neighbours of the image of the parent, or any vertex for the first of a component
+        int from = 0, to = g2.n, p2 = parent[d] < 0 ? -1 : core1[order[parent[d]]];
+        if (p2 >= 0)
+        {
+            from = g2.start[p2];
+            to = g2.start[p2 + 1];
+        }
+        for (int k = from; k < to; k++)
+        {
+            int v2 = p2 >= 0 ? g2.nbr[k] : k;
+            if (!feasible(v1, v2))
+                continue;
+            core1[v1] = v2;
+            core2[v2] = v1;
+            if (match(d + 1))
+                return true;
+            core1[v1] = -1;
+            core2[v2] = -1;
+        }
+        return false;
+    }
+};
+
+bool vf2GraphIso(const labelledGraph &g1, const labelledGraph &g2)
+{
+    if (g1.n != g2.n || g1.nbr.size() != g2.nbr.size())
+        return false;
+    // The atom types and degrees must agree as multisets before any matching is tried
+    vector<long long> keys1(g1.n), keys2(g2.n);
+    for (int v = 0; v < g1.n; v++)
+    {
+        keys1[v] = (long long)g1.type[v] << 32 | g1.degree(v);
+        keys2[v] = (long long)g2.type[v] << 32 | g2.degree(v);
+    }
+    vector<long long> sorted1 = keys1;
+    sort(sorted1.begin(), sorted1.end());
+    sort(keys2.begin(), keys2.end());
+    if (sorted1 != keys2)
+        return false;
+    vi rarity(g1.n);
+    for (int v = 0; v < g1.n; v++)
+    {
+        auto range = equal_range(sorted1.begin(), sorted1.end(), keys1[v]);
+        rarity[v] = range.second - range.first;
+    }
+    vf2State state(g1, g2);
+    state.orderVertices(rarity);
+    return state.match(0);
+}
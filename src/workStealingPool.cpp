@@ -0,0 +1,116 @@
+#include "workStealingPool.h"
+#include <chrono>  // for microseconds
+#include <cstddef> // for size_t
+#include <thread>  // for thread, yield, sleep_for
+#include <utility> // for move
+#include <vector>  // for vector
+#include "globalPrimitives.h" // for FOR_EACH_MASK_WIDTH
+
+using namespace std;
+
+/// Workers keep spawning subtrees until they have this many tasks queued for thieves to take
+constexpr size_t SPAWN_THRESHOLD = 2;
+
+/// Index of the pool worker running on this thread, -1 outside the pool
+thread_local int currentWorker = -1;
+
+template <size_t W>
+void workStealingPool<W>::submit(assemblyState<W> &as, int bound)
+{
+    workerQueue<W> &q = queues[nextQueue];
+    nextQueue = (nextQueue + 1) % queues.size();
+    pending++;
+    lock_guard<mutex> lock(q.lock);
+    q.tasks.emplace_front(as, bound);
+    q.size = q.tasks.size();
+}
+
+template <size_t W>
+bool workStealingPool<W>::trySpawn(assemblyState<W> &as, int bound)
+{
+    if (currentWorker < 0)
+        return false;
+    workerQueue<W> &q = queues[currentWorker];
+    if (q.size >= SPAWN_THRESHOLD)
+        return false;
+    pending++;
+    lock_guard<mutex> lock(q.lock);
+    q.tasks.emplace_back(as, bound);
+    q.size = q.tasks.size();
+    return true;
+}
+
+template <size_t W>
+bool workStealingPool<W>::popLocal(size_t worker, searchTask<W> &t)
+{
+    workerQueue<W> &q = queues[worker];
+    if (q.size == 0)
+        return false;
+    lock_guard<mutex> lock(q.lock);
+    if (q.tasks.empty())
+        return false;
+    t = move(q.tasks.back());
+    q.tasks.pop_back();
+    q.size = q.tasks.size();
+    return true;
+}
+
+template <size_t W>
+bool workStealingPool<W>::steal(size_t worker, searchTask<W> &t)
+{
+    for (size_t k = 1; k < queues.size(); k++)
+    {
+        workerQueue<W> &q = queues[(worker + k) % queues.size()];
+        if (q.size == 0)
+            continue;
+        lock_guard<mutex> lock(q.lock);
+        if (q.tasks.empty())
+            continue;
+        t = move(q.tasks.front());
+        q.tasks.pop_front();
+        q.size = q.tasks.size();
+        return true;
+    }
+    return false;
+}
+
+template <size_t W>
+void workStealingPool<W>::workerLoop(size_t worker, const function<void(searchTask<W> &)> &execute)
+{
+    currentWorker = worker;
+    int idleRounds = 0;
+    searchTask<W> t;
+    while (true)
+    {
+        if (popLocal(worker, t) || steal(worker, t))
+        {
+            idleRounds = 0;
+            execute(t);
+            pending--;
+            continue;
+        }
+        // A task that is still executing may spawn more work, so only stop once nothing is pending
+        if (pending == 0)
+            break;
+        if (++idleRounds < 64)
+            this_thread::yield();
+        else
+            this_thread::sleep_for(chrono::microseconds(50));
+    }
+    currentWorker = -1;
+}
+
+template <size_t W>
+void workStealingPool<W>::run(const function<void(searchTask<W> &)> &execute)
+{
+    vector<thread> threads;
+    for (size_t i = 1; i < queues.size(); i++)
+        threads.emplace_back(&workStealingPool<W>::workerLoop, this, i, cref(execute));
+    workerLoop(0, execute);
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+}
+
+/// Explicit instantiations for every mask width
+#define INSTANTIATE_WORK_STEALING_POOL(W) template struct workStealingPool<W>;
+FOR_EACH_MASK_WIDTH(INSTANTIATE_WORK_STEALING_POOL)
@@ -0,0 +1,72 @@
+import os
+import random
+import subprocess
+import sys
+
+# Bond counts of the generated graphs, from the widest fixed mask of 512 bits to ten times it
+BOND_COUNTS = [500, 1000, 1500, 2000, 2500, 3000, 4000, 5000]
+TIMEOUT = 600
+
+
+def write_copolymer(path, name, bonds, seed):
+    """Writes a random copolymer chain with the given number of bonds in graphio format.
+
+    Atom types are drawn from an alphabet of bonds / 15 types, so that the chain has repeated
+    fragments to find but few enough for the search to finish."""
+    rng = random.Random(seed)
+    atoms = bonds + 1
+    alphabet = max(8, bonds // 15)
+    with open(path, 'w') as f:
+        f.write(f"{name}\n{atoms}\n")
+        f.write(' '.join(f"{i} {i + 1}" for i in range(1, atoms)) + "\n")
+        f.write(' '.join(f"X{rng.randrange(alphabet)}" for _ in range(atoms)) + "\n")
+        f.write(' '.join('1' for _ in range(bonds)) + "\n")
+
+
+def run_scaling(exe_path):
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    work_dir = os.path.join(script_dir, "scaling")
+    summary_path = os.path.join(script_dir, "scaling_summary.txt")
+    os.makedirs(work_dir, exist_ok=True)
+    exe_path = os.path.abspath(exe_path)
+
+    results = ["bonds, assembly index, time to completion"]
+    for bonds in BOND_COUNTS:
+        name = f"copolymer{bonds}"
+        write_copolymer(os.path.join(work_dir, name), name, bonds, bonds)
+        try:
+            subprocess.run([exe_path, name], cwd=work_dir, check=True, timeout=TIMEOUT,
+                           stdout=subprocess.DEVNULL)
+        except subprocess.TimeoutExpired:
+            line = f"{bonds}, timeout, >{TIMEOUT}s"
+            print(line)
+            results.append(line)
+            continue
+        except subprocess.CalledProcessError as e:
+            line = f"{bonds}, error, {e}"
+            print(line)
+            results.append(line)
+            continue
+
+        with open(os.path.join(work_dir, f"{name}Out"), 'r') as out_f:
+            lines = out_f.readlines()
+        index = lines[0].split(":")[1].strip() if lines else "missing"
+        time_line = next((l for l in lines if l.startswith("time to completion:")), None)
+        time_value = time_line.split(":")[1].strip() if time_line else "missing"
+        line = f"{bonds}, {index}, {time_value}"
+        print(line)
+        results.append(line)
+
+    with open(summary_path, 'w') as out_f:
+        for line in results:
+            out_f.write(line + "\n")
+
+    print(f"\nResults written to: {summary_path}")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        print("Usage: python3 scaling.py <path_to_assembly_exe>")
+        sys.exit(1)
+
+    run_scaling(sys.argv[1])
@@ -0,0 +1,45 @@
+#include <catch2/catch_all.hpp>
+#include <bitset>
+#include <unordered_map>
+#include "dynamicBitset.h"
+
+TEST_CASE("dynamicBitset matches std::bitset across word boundaries", "[dynamicBitset]")
+{
+    dynamicBitset::setWidth(200);
+    dynamicBitset a, b;
+    std::bitset<256> sa, sb;
+    REQUIRE(a.size() == 256);
+    REQUIRE(a.none());
+
+    for (size_t i : {0, 5, 63, 64, 127, 128, 199})
+    {
+        a[i] = 1;
+        sa[i] = 1;
+    }
+    for (size_t i : {5, 64, 65, 130, 199})
+    {
+        b.set(i);
+        sb.set(i);
+    }
+    REQUIRE(a.count() == sa.count());
+    REQUIRE((a & b).count() == (sa & sb).count());
+    REQUIRE((a | b).count() == (sa | sb).count());
+    REQUIRE((a ^ b).count() == (sa ^ sb).count());
+    REQUIRE((~a).count() == (~sa).count());
+    for (size_t i = 0; i < 200; i++)
+        REQUIRE((a & ~b)[i] == (sa & ~sb)[i]);
+
+    a.reset(64);
+    REQUIRE(!a.test(64));
+    REQUIRE(a != b);
+    b = a;
+    REQUIRE(a == b);
+    REQUIRE(std::hash<dynamicBitset>()(a) == std::hash<dynamicBitset>()(b));
+
+    std::unordered_map<dynamicBitset, int> table;
+    table[a] = 1;
+    b.flip(199);
+    table[b] = 2;
+    REQUIRE(table.size() == 2);
+    REQUIRE(table[a] == 1);
+}
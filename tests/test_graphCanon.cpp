@@ -0,0 +1,101 @@
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <bitset>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include "graphCanon.h"
+#include "molfileParser.h"
+#include "molGraph.h"
+#include "test_utils.h" // for CoutSilencer, randomSubgraphs
+#include "vf2.h"
+
+extern std::filesystem::path g_repo_root;
+
+static molGraph smallGraph(const std::vector<std::string> &types, const std::vector<std::pair<int, int>> &bonds)
+{
+    molGraph mg;
+    for (std::string t : types)
+        mg.addAtom(t);
+    for (const std::pair<int, int> &b : bonds)
+        mg.addBond(b.first, b.second, 1);
+    return mg;
+}
+
+TEST_CASE("canonicalCertificate separates regular graphs that colour refinement alone cannot", "[graphCanon]")
+{
+    std::vector<std::string> carbons(6, "C");
+    molGraph hexagon = smallGraph(carbons, {{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 0}});
+    molGraph triangles = smallGraph(carbons, {{0, 1}, {1, 2}, {2, 0}, {3, 4}, {4, 5}, {5, 3}});
+    molGraph prism = smallGraph(carbons, {{0, 1}, {1, 2}, {2, 0}, {3, 4}, {4, 5}, {5, 3}, {0, 3}, {1, 4}, {2, 5}});
+    molGraph k33 = smallGraph(carbons, {{0, 3}, {0, 4}, {0, 5}, {1, 3}, {1, 4}, {1, 5}, {2, 3}, {2, 4}, {2, 5}});
+    molGraph hexagonRelabelled = smallGraph(carbons, {{3, 0}, {0, 5}, {5, 1}, {1, 4}, {4, 2}, {2, 3}});
+    REQUIRE(canonicalCertificate(toLabelledGraph(hexagon)) != canonicalCertificate(toLabelledGraph(triangles)));
+    REQUIRE(canonicalCertificate(toLabelledGraph(prism)) != canonicalCertificate(toLabelledGraph(k33)));
+    REQUIRE(canonicalCertificate(toLabelledGraph(hexagon)) == canonicalCertificate(toLabelledGraph(hexagonRelabelled)));
+
+    std::vector<std::string> types = carbons;
+    types[2] = "N";
+    molGraph pyridine = smallGraph(types, {{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 0}});
+    REQUIRE(canonicalCertificate(toLabelledGraph(hexagon)) != canonicalCertificate(toLabelledGraph(pyridine)));
+}
+
+TEST_CASE("canonicalCertificate agrees with vf2 on random subgraphs of a macrolide", "[graphCanon]")
+{
+    std::ifstream molFile(g_repo_root / "tests/speed/molfiles/erythromycin.mol");
+    REQUIRE(molFile.is_open());
+    molGraph mg;
+    {
+        CoutSilencer silence;
+        molfileParser(molFile, mg);
+    }
+    std::vector<edgeL> edges = mg.writeEdgeList();
+    REQUIRE(edges.size() <= 512);
+    std::mt19937 rng(12345);
+
+    // Several subgraphs of each size, so that some are isomorphic
+    std::vector<std::bitset<512>> masks = randomSubgraphs(mg.mg.size(), edges, {6, 8, 10, 12}, 40, rng);
+
+    std::vector<std::string> certificates;
+    for (std::bitset<512> &mask : masks)
+    {
+        bool isCyclic;
+        molGraph fragment = constructFromEdgeList<512>(mg, edges, mask, isCyclic);
+        certificates.push_back(canonicalCertificate(toLabelledGraph(fragment)));
+        REQUIRE(canonicalCertificate(toLabelledGraph<512>(mg, edges, mask)) == certificates.back());
+
+        // The same fragment with its atoms in another order
+        std::vector<int> perm(fragment.mg.size());
+        std::iota(perm.begin(), perm.end(), 0);
+        std::shuffle(perm.begin(), perm.end(), rng);
+        molGraph shuffled;
+        for (size_t i = 0; i < perm.size(); i++)
+            shuffled.addAtom(fragment.mg[perm[i]].type);
+        std::vector<int> where(perm.size());
+        for (size_t i = 0; i < perm.size(); i++)
+            where[perm[i]] = i;
+        for (size_t a = 0; a < fragment.mg.size(); a++)
+            for (const bond &b : fragment.mg[a].list)
+                if (size_t(b.n) > a)
+                    shuffled.addBond(where[a], where[b.n], b.type);
+        REQUIRE(canonicalCertificate(toLabelledGraph(shuffled)) == certificates.back());
+    }
+
+    int isomorphic = 0;
+    for (size_t i = 0; i < masks.size(); i++)
+    {
+        for (size_t j = i + 1; j < masks.size(); j++)
+        {
+            if (masks[i].count() != masks[j].count())
+                continue;
+            molGraphBoost a = edgelistToBoost<512>(mg, edges, masks[i]), b = edgelistToBoost<512>(mg, edges, masks[j]);
+            bool iso = vf2GraphIso(a, b);
+            isomorphic += iso;
+            REQUIRE((certificates[i] == certificates[j]) == iso);
+        }
+    }
+    REQUIRE(isomorphic > 0);
+}
@@ -1,7 +1,10 @@
 #include <catch2/catch_all.hpp>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <regex>
 #include <sstream>
 #include <string>
@@ -97,7 +100,7 @@ void cleanup_outputs(const fs::path &directory)
     }
 }
 
-TEST_CASE("Integration tests for ./build/bin/assembly")
+fs::path find_assembly_binary()
 {
     extern std::filesystem::path g_repo_root;
 
@@ -126,12 +129,32 @@ TEST_CASE("Integration tests for ./build/bin/assembly")
              "Did you forget to build it?");
     }
 #endif
+    return binary;
+}
+
+// clang-format off
+#ifdef _WIN32
+    const std::string null_redirect = " > NUL";
+#else
+    const std::string null_redirect = " > /dev/null";
+#endif
+// clang-format on
+
+/**
+ * Runs the first `limit` molecules of the integration data (all of them if 0) with the given command line flags
+ * and checks each assembly index. Failures and timings are logged to files named with `suffix`
+ */
+void run_integration(const std::string &flags, size_t limit, const std::string &suffix)
+{
+    extern std::filesystem::path g_repo_root;
+
+    fs::path binary = find_assembly_binary();
 
     const auto csv_file = g_repo_root / "tests/integration/integration_test_data.csv";
     const auto mol_dir = g_repo_root / "tests/integration/molfiles";
 
-    const auto failure_log_path = g_repo_root / "integration_failures.txt";
-    const auto timing_csv_path = g_repo_root / "integration_timings.csv";
+    const auto failure_log_path = g_repo_root / ("integration_failures" + suffix + ".txt");
+    const auto timing_csv_path = g_repo_root / ("integration_timings" + suffix + ".csv");
 
     std::ofstream log_file(failure_log_path);
     std::ofstream timing_csv(timing_csv_path);
@@ -148,7 +171,9 @@ TEST_CASE("Integration tests for ./build/bin/assembly")
     timing_csv << "molecule,assembly_index,expected_index,time_seconds,status\n";
 
     auto test_cases = read_csv(csv_file);
-    std::cout << "Loaded test cases: " << test_cases.size() << "\n";
+    if (limit > 0 && test_cases.size() > limit)
+        test_cases.resize(limit);
+    std::cout << "Loaded test cases: " << test_cases.size() << (flags.empty() ? "" : " with " + flags) << "\n";
 
     int passed = 0;
     int failed = 0;
@@ -163,16 +188,7 @@ TEST_CASE("Integration tests for ./build/bin/assembly")
         std::string mol_path = (mol_dir / base).string();
         std::string out_file = (mol_dir / (base + "Out")).string();
 
-        // clang-format off
-        #ifdef _WIN32
-                const std::string null_redirect = " > NUL";
-        #else
-                const std::string null_redirect = " > /dev/null";
-        #endif
-        // clang-format on
-
-        std::string cmd = binary.string() + " " + mol_path + null_redirect;
-
+        std::string cmd = binary.string() + " " + mol_path + (flags.empty() ? "" : " " + flags) + null_redirect;
         std::cout << "[ " << index << " / " << total << " ] " << base << "\r" << std::flush;
 
         auto t0 = std::chrono::steady_clock::now();
@@ -220,7 +236,7 @@ TEST_CASE("Integration tests for ./build/bin/assembly")
                 {
                     status = "FAIL";
                     std::ostringstream msg;
-                    msg << "[FAIL] " << base << " → expected: " << expected_index
+                    msg << "[FAIL] " << base << (flags.empty() ? "" : " " + flags) << " → expected: " << expected_index
                         << ", got: " << maybe_result->index;
                     log_file << msg.str() << "\n";
                     INFO(msg.str());
@@ -245,7 +261,8 @@ TEST_CASE("Integration tests for ./build/bin/assembly")
     timing_csv.close();
     if (failed == 0)
     {
-        std::cout << "\nAll integration tests passed on " << passed << " molecules.\n";
+        std::cout << "\nAll integration tests passed on " << passed << " molecules"
+                  << (flags.empty() ? "" : " with " + flags) << ".\n";
         fs::remove(failure_log_path); // keep timings, but remove failure log if clean
     }
     else
@@ -255,4 +272,160 @@ TEST_CASE("Integration tests for ./build/bin/assembly")
     }
 
     REQUIRE(failed == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Integration tests for ./build/bin/assembly")
+{
+    run_integration("", 0, "");
+}
+
+TEST_CASE("Integration tests in the other search modes reach the same assembly index")
+{
+    // Each mode searches in another order, or on several threads, and must prove the same index as the default
+    // depth-first search. A subset of the molecules keeps the run short
+    std::string flags = GENERATE(as<std::string>{}, "-threads=4", "-bestFirst=1", "-branchOrder=1", "-sliceNodes=50");
+    DYNAMIC_SECTION(flags)
+    {
+        std::string suffix = flags.substr(1, flags.find('=') - 1);
+        run_integration(flags, 200, "_" + suffix);
+    }
+}
+
+/// Whole contents of a file, empty if it cannot be read
+std::string read_file(const fs::path &path)
+{
+    std::ifstream f(path);
+    std::stringstream contents;
+    contents << f.rdbuf();
+    return contents.str();
+}
+
+/// Empty scratch directory for tests that run the binary, as it writes its output files next to the molfile
+fs::path scratch_directory(const std::string &name)
+{
+    const fs::path dir = fs::temp_directory_path() / name;
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+/// Number of [a,b] pairs in a line of a Pathway file
+int count_pairs(const std::string &line)
+{
+    static const std::regex pair_pattern(R"(\[\d+,\d+\])");
+    return std::distance(std::sregex_iterator(line.begin(), line.end(), pair_pattern), std::sregex_iterator());
+}
+
+TEST_CASE("Decision queries answer whether the assembly index is at most a threshold")
+{
+    extern std::filesystem::path g_repo_root;
+
+    fs::path binary = find_assembly_binary();
+    const fs::path dir = scratch_directory("assembly_decision_test");
+    fs::copy_file(g_repo_root / "tests/data/tryptophan.mol", dir / "tryptophan.mol");
+    const fs::path out_file = dir / "tryptophanOut";
+    const fs::path pathway_file = dir / "tryptophanPathway";
+
+    auto run = [&](int threshold)
+    {
+        fs::remove(out_file);
+        fs::remove(pathway_file);
+        std::string cmd = binary.string() + " " + (dir / "tryptophan").string() +
+                          " -threshold=" + std::to_string(threshold) + " -pathway=1" + null_redirect;
+        REQUIRE(std::system(cmd.c_str()) == 0);
+        REQUIRE(fs::exists(out_file));
+        return read_file(out_file);
+    };
+
+    // Tryptophan has assembly index 11
+    SECTION("below the assembly index")
+    {
+        std::string out = run(10);
+        CHECK(out.find("verdict: no\n") != std::string::npos);
+        CHECK_FALSE(fs::exists(pathway_file));
+    }
+
+    SECTION("at the assembly index")
+    {
+        std::string out = run(11);
+        CHECK(out.find("verdict: yes, witness pathway with assembly index 11\n") != std::string::npos);
+
+        // The witness takes one step per bond, less the bonds saved by each duplicate
+        std::ifstream f(pathway_file);
+        REQUIRE(f.is_open());
+        std::string line;
+        int bonds = -1, saved = 0;
+        while (std::getline(f, line))
+        {
+            if (bonds < 0 && line.rfind("\"Edges\":", 0) == 0)
+                bonds = count_pairs(line);
+            size_t right = line.find("\"Right\":");
+            if (right != std::string::npos)
+                saved += count_pairs(line.substr(right)) - 1;
+        }
+        CHECK(bonds - 1 - saved == 11);
+    }
+    fs::remove_all(dir);
+}
+
+TEST_CASE("A checkpointed search resumes to the same assembly index and rejects other molecules' checkpoints")
+{
+    extern std::filesystem::path g_repo_root;
+
+    fs::path binary = find_assembly_binary();
+    const fs::path dir = scratch_directory("assembly_checkpoint_test");
+    for (std::string base : {"ketoconazole", "Ceftiolene"})
+        fs::copy_file(g_repo_root / "tests/integration/molfiles" / (base + ".mol"), dir / (base + ".mol"));
+    const fs::path checkpoint = dir / "search.ckpt";
+    const fs::path log = dir / "stdout.txt";
+
+    // Runs the binary on a molecule of the scratch directory and returns what it printed
+    auto run = [&](const std::string &base, const std::string &flags)
+    {
+        fs::remove(dir / (base + "Out"));
+        std::string cmd = binary.string() + " " + (dir / base).string() + " " + flags + " > " + log.string();
+        REQUIRE(std::system(cmd.c_str()) == 0);
+        return read_file(log);
+    };
+
+    // Ketoconazole takes a few tenths of a second, so a run stopped after 60 ms leaves part of the search to the
+    // checkpoint, which is written every 20 expansions
+    run("ketoconazole", "-checkpoint=" + checkpoint.string() + " -checkpointNodes=20 -runTime=60000");
+    REQUIRE(fs::exists(checkpoint));
+
+    SECTION("resumed")
+    {
+        std::string out = run("ketoconazole", "-resume=" + checkpoint.string());
+        CHECK(out.find("resuming from " + checkpoint.string()) != std::string::npos);
+        auto result = extract_result((dir / "ketoconazoleOut").string());
+        REQUIRE(result.has_value());
+        CHECK(result->index == 22);
+        CHECK(out.find("min AI found: 22 proven lower bound: 22 optimality gap: 0\n") != std::string::npos);
+    }
+
+    SECTION("another molecule of the same mask width")
+    {
+        std::string out = run("Ceftiolene", "-resume=" + checkpoint.string());
+        CHECK(out.find("could not resume from " + checkpoint.string()) != std::string::npos);
+        auto result = extract_result((dir / "CeftioleneOut").string());
+        REQUIRE(result.has_value());
+        CHECK(result->index == 23);
+    }
+
+    SECTION("another mask width")
+    {
+        // A chain of 80 carbons has 79 bonds, too many for the 64-bit masks of ketoconazole. The new search it
+        // falls back to is stopped straight away
+        std::ofstream chain(dir / "chain.mol");
+        chain << "chain\n\n\n 80 79  0  0  0  0  0  0  0  0999 V2000\n";
+        for (int i = 0; i < 80; i++)
+            chain << "    0.0000    0.0000    0.0000 C   0  0  0  0  0  0  0  0  0  0  0  0\n";
+        for (int i = 1; i < 80; i++)
+            chain << std::setw(3) << i << std::setw(3) << i + 1 << "  1  0\n";
+        chain << "M  END\n";
+        chain.close();
+        std::string out = run("chain", "-resume=" + checkpoint.string() + " -runTime=1");
+        CHECK(out.find("could not resume from " + checkpoint.string()) != std::string::npos);
+    }
+    fs::remove_all(dir);
+}
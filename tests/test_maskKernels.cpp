@@ -0,0 +1,111 @@
+#include <catch2/catch_all.hpp>
+#include <bitset>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "maskKernels.h"
+
+// Random masks of words 64-bit words, sparse enough that subsets and disjoint pairs occur
+static std::vector<std::vector<uint64_t>> randomMasks(size_t count, size_t words, unsigned seed)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<std::vector<uint64_t>> masks(count, std::vector<uint64_t>(words));
+    for (size_t i = 0; i < count; i++)
+        for (size_t w = 0; w < words; w++)
+            masks[i][w] = rng() & rng() & rng();
+    for (size_t i = 1; i < count; i += 4)
+        for (size_t w = 0; w < words; w++)
+            masks[i][w] = masks[i - 1][w] & rng();
+    return masks;
+}
+
+TEST_CASE("every supported mask kernel set agrees with the scalar kernels", "[maskKernels]")
+{
+    std::vector<const maskKernelSet *> sets = supportedMaskKernels();
+    const maskKernelSet &scalar = *sets.front();
+    for (size_t words : {1, 3, 4, 5, 8, 13})
+    {
+        std::vector<std::vector<uint64_t>> masks = randomMasks(16, words, unsigned(words));
+        for (const maskKernelSet *k : sets)
+        {
+            for (size_t i = 0; i < masks.size(); i++)
+            {
+                for (size_t j = 0; j < masks.size(); j++)
+                {
+                    const uint64_t *a = masks[i].data(), *b = masks[j].data();
+                    REQUIRE(k->subset(a, b, words) == scalar.subset(a, b, words));
+                    REQUIRE(k->disjoint(a, b, words) == scalar.disjoint(a, b, words));
+                    REQUIRE(k->andCount(a, b, words) == scalar.andCount(a, b, words));
+                }
+            }
+            std::vector<const uint64_t *> srcs;
+            for (size_t i = 0; i < masks.size(); i++)
+                srcs.push_back(masks[i].data());
+            std::vector<uint64_t> expected(words, 0), got(words, 0);
+            scalar.orReduce(expected.data(), srcs.data(), srcs.size(), words);
+            k->orReduce(got.data(), srcs.data(), srcs.size(), words);
+            REQUIRE(got == expected);
+        }
+    }
+}
+
+TEST_CASE("the words of a std::bitset hold bit i in bit i % 64 of word i / 64", "[maskKernels]")
+{
+    std::bitset<512> m;
+    for (size_t i : {0, 1, 63, 64, 200, 511})
+        m.set(i);
+    const uint64_t *w = maskWords(m);
+    REQUIRE(w[0] == (uint64_t(1) | uint64_t(1) << 1 | uint64_t(1) << 63));
+    REQUIRE(w[1] == uint64_t(1));
+    REQUIRE(w[3] == uint64_t(1) << (200 - 192));
+    REQUIRE(w[7] == uint64_t(1) << 63);
+    REQUIRE((w[2] | w[4] | w[5] | w[6]) == 0);
+
+    // Writing through the words is seen by the bitset
+    maskWords(m)[2] = uint64_t(1) << 5;
+    REQUIRE(m.test(133));
+    REQUIRE(m.count() == 7);
+}
+
+TEST_CASE("mask kernel microbenchmark on 512-bit masks", "[.][benchmark][maskKernels]")
+{
+    const size_t words = 8;
+    std::vector<std::vector<uint64_t>> masks = randomMasks(256, words, 512);
+    for (const maskKernelSet *k : supportedMaskKernels())
+    {
+        std::string name = k->name;
+        BENCHMARK(name + " subset")
+        {
+            size_t n = 0;
+            for (size_t i = 0; i < masks.size(); i++)
+                n += k->subset(masks[i].data(), masks[(i + 1) % masks.size()].data(), words);
+            return n;
+        };
+        BENCHMARK(name + " disjoint")
+        {
+            size_t n = 0;
+            for (size_t i = 0; i < masks.size(); i++)
+                n += k->disjoint(masks[i].data(), masks[(i + 7) % masks.size()].data(), words);
+            return n;
+        };
+        BENCHMARK(name + " andCount")
+        {
+            size_t n = 0;
+            for (size_t i = 0; i < masks.size(); i++)
+                n += k->andCount(masks[i].data(), masks[(i + 7) % masks.size()].data(), words);
+            return n;
+        };
+        BENCHMARK(name + " orReduce")
+        {
+            std::vector<uint64_t> dst(words, 0);
+            for (size_t i = 0; i + 8 <= masks.size(); i += 8)
+            {
+                const uint64_t *srcs[8];
+                for (size_t j = 0; j < 8; j++)
+                    srcs[j] = masks[i + j].data();
+                k->orReduce(dst.data(), srcs, 8, words);
+            }
+            return dst[0];
+        };
+    }
+}
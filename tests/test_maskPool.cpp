@@ -0,0 +1,159 @@
+#include <catch2/catch_all.hpp>
+#include <bitset>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "maskPool.h"
+#include "molfileParser.h"
+#include "molGraph.h"
+#include "test_utils.h" // for CoutSilencer
+
+extern std::filesystem::path g_repo_root;
+
+TEST_CASE("maskPool gives equal masks equal IDs and keeps masks in place as it grows", "[maskPool]")
+{
+    maskPool<128> pool;
+    std::bitset<128> a, b;
+    a.set(3);
+    a.set(100);
+    b.set(3);
+    maskId idA = pool.intern(a);
+    REQUIRE(pool.intern(b) != idA);
+    b.set(100);
+    REQUIRE(pool.intern(b) == idA);
+    const std::bitset<128> &pooled = pool[idA];
+
+    // Enough masks to span several chunks and rehash the index a few times
+    std::vector<maskId> ids;
+    for (size_t i = 0; i < 3 * maskPool<128>::CHUNK_SIZE; i++)
+    {
+        std::bitset<128> m(i);
+        m.set(127);
+        ids.push_back(pool.intern(m));
+    }
+    REQUIRE(&pool[idA] == &pooled);
+    REQUIRE(pooled == a);
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        std::bitset<128> m(i);
+        m.set(127);
+        maskId id;
+        REQUIRE(pool.find(m, id));
+        REQUIRE(id == ids[i]);
+        REQUIRE(pool[id] == m);
+    }
+    std::bitset<128> missing;
+    missing.set(126);
+    maskId id;
+    REQUIRE(!pool.find(missing, id));
+
+    pool.clear();
+    REQUIRE(pool.size() == 0);
+    REQUIRE(!pool.find(a, id));
+}
+
+// The masks canonised while enumerating the connected subgraphs of a speed-test molecule, in order and with the
+// repeats the enumeration produces: every subgraph is reached once from each subgraph one bond smaller
+static std::vector<std::bitset<512>> enumerationTrace(const std::string &name, size_t limit)
+{
+    std::ifstream molFile(g_repo_root / "tests/speed/molfiles" / (name + ".mol"));
+    REQUIRE(molFile.is_open());
+    molGraph mg;
+    {
+        CoutSilencer silence;
+        molfileParser(molFile, mg);
+    }
+    std::vector<std::pair<size_t, size_t>> edges;
+    for (size_t i = 0; i < mg.mg.size(); i++)
+        for (const bond &b : mg.mg[i].list)
+            if (size_t(b.n) > i)
+                edges.emplace_back(i, b.n);
+    REQUIRE(edges.size() <= 512);
+    // Bonds sharing an atom with each bond
+    std::vector<std::bitset<512>> adjacent(edges.size());
+    for (size_t i = 0; i < edges.size(); i++)
+        for (size_t j = 0; j < edges.size(); j++)
+            if (i != j && (edges[i].first == edges[j].first || edges[i].first == edges[j].second ||
+                           edges[i].second == edges[j].first || edges[i].second == edges[j].second))
+                adjacent[i].set(j);
+
+    std::vector<std::bitset<512>> trace, level;
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        level.emplace_back();
+        level.back().set(i);
+        trace.push_back(level.back());
+    }
+    while (!level.empty() && trace.size() < limit)
+    {
+        std::unordered_set<std::bitset<512>> next;
+        for (const std::bitset<512> &m : level)
+        {
+            std::bitset<512> frontier;
+            for (size_t i = 0; i < edges.size(); i++)
+                if (m[i])
+                    frontier |= adjacent[i];
+            frontier &= ~m;
+            for (size_t i = 0; i < edges.size() && trace.size() < limit; i++)
+            {
+                if (!frontier[i])
+                    continue;
+                std::bitset<512> grown = m;
+                grown.set(i);
+                trace.push_back(grown);
+                next.insert(grown);
+            }
+        }
+        level.assign(next.begin(), next.end());
+    }
+    return trace;
+}
+
+TEST_CASE("canonisation table microbenchmark on the speed-test molecules", "[.][benchmark][maskPool]")
+{
+    for (const std::string name : {"brucine", "cefiderocol", "clarithromycin", "erythromycin", "iodotaxol", "YFWHP"})
+    {
+        std::vector<std::bitset<512>> trace = enumerationTrace(name, 200000);
+        // The lookups of canonise before the pool: count, then operator[] twice
+        BENCHMARK(name + " unordered_map")
+        {
+            std::unordered_map<std::bitset<512>, pii> table;
+            int classes = 0;
+            for (const std::bitset<512> &m : trace)
+            {
+                if (table.count(m) == 0)
+                {
+                    table[m].first = classes++;
+                    table[m].second = 1;
+                }
+                else
+                    classes += table[m].first & 1;
+            }
+            return table.size();
+        };
+        // The lookups of canonise with the pool: find under the shared lock, then intern and tryEmplace
+        BENCHMARK(name + " maskPool")
+        {
+            maskPool<512> pool;
+            canonTable table;
+            int classes = 0;
+            for (const std::bitset<512> &m : trace)
+            {
+                maskId id;
+                pii found;
+                if (pool.find(m, id) && table.find(id, found))
+                {
+                    classes += found.first & 1;
+                    continue;
+                }
+                std::pair<pii *, bool> entry = table.tryEmplace(pool.intern(m));
+                if (entry.second)
+                    *entry.first = pii(classes++, 1);
+            }
+            return table.size();
+        };
+    }
+}
@@ -43,4 +43,19 @@ TEST_CASE("molfileParser correctly parses tryptophan.mol", "[molfileParser]")
     REQUIRE(mg.degree(0) == 2);
     REQUIRE(mg.atype(0) == "C");
     REQUIRE(mg.atype(14) == "O");
+    // Atoms with the same label share its ID
+    REQUIRE(mg.mg[0].type == atomLabels.intern("C"));
+    REQUIRE(mg.mg[14].type == atomLabels.intern("O"));
+    REQUIRE(mg.mg[0].type != mg.mg[14].type);
+}
+
+TEST_CASE("labelDictionary refuses a label once its IDs run out", "[molGraph]")
+{
+    labelDictionary labels;
+    for (int i = 0; i < REMOVED_LABEL; i++)
+        REQUIRE(labels.intern("X" + std::to_string(i)) == i);
+    // REMOVED_LABEL is reserved for atoms marked for removal
+    REQUIRE_THROWS_AS(labels.intern("Y"), std::length_error);
+    REQUIRE(labels.intern("X0") == 0);
+    REQUIRE(labels.names.size() == REMOVED_LABEL);
 }
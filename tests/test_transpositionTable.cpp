@@ -0,0 +1,163 @@
+#include <catch2/catch_all.hpp>
+#include "pathArena.h"
+#include "transpositionTable.h"
+
+TEST_CASE("transpositionTable claims new states and improved revisits only", "[transpositionTable]")
+{
+    transpositionTable table;
+    vi key = {3, 1, 2};
+
+    vi k1 = key;
+    pathPtr first = table.tryClaim(k1, 4, nullptr, 1, 2);
+    REQUIRE(first != nullptr);
+    REQUIRE(first->hasKey(key));
+    REQUIRE(table.size() == 1);
+
+    // Reached again with no more duplicated bonds: nothing to search
+    vi k2 = key;
+    REQUIRE(table.tryClaim(k2, 4, nullptr, 5, 6) == nullptr);
+    REQUIRE(first->match == 1);
+
+    // Reached with more duplicated bonds: same node, updated to the new pathway
+    vi k3 = key;
+    pathPtr better = table.tryClaim(k3, 6, first, 5, 6);
+    REQUIRE(better == first);
+    REQUIRE(first->sumDupBonds == 6);
+    REQUIRE(first->parent == first);
+    REQUIRE(table.size() == 1);
+
+    first = better = nullptr;
+    table.clear();
+    REQUIRE(table.size() == 0);
+}
+
+TEST_CASE("transpositionTable keeps distinct keys apart as it grows", "[transpositionTable]")
+{
+    transpositionTable table;
+    for (int i = 0; i < 5000; i++)
+    {
+        vi key = {i, i % 7, i % 13};
+        REQUIRE(table.tryClaim(key, 1, nullptr, 0, 0) != nullptr);
+    }
+    REQUIRE(table.size() == 5000);
+    for (int i = 0; i < 5000; i++)
+    {
+        vi key = {i, i % 7, i % 13};
+        REQUIRE(table.tryClaim(key, 1, nullptr, 0, 0) == nullptr);
+    }
+    table.clear();
+}
+
+TEST_CASE("transpositionTable finds and lists stored nodes", "[transpositionTable]")
+{
+    transpositionTable table;
+    vi key = {4, 2};
+    REQUIRE(table.find(key) == nullptr);
+    vi k1 = key;
+    pathPtr ap = table.tryClaim(k1, 3, nullptr, 0, 0);
+    REQUIRE(table.find(key) == ap);
+    for (int i = 0; i < 100; i++)
+    {
+        vi k = {i, -1};
+        table.tryClaim(k, 1, ap, 0, 0);
+    }
+    std::vector<pathPtr> nodes = table.nodes();
+    REQUIRE(nodes.size() == 101);
+    nodes.clear();
+    ap = nullptr;
+    table.clear();
+}
+
+TEST_CASE("transpositionTable evicts entries to stay within its memory limit", "[transpositionTable]")
+{
+    transpositionTable table;
+    table.setMemoryLimit(64 * 1024);
+    vi pinnedKey = {-1, -1};
+    vi k = pinnedKey;
+    pathPtr pinned = table.tryClaim(k, 0, nullptr, 0, 0);
+    for (int i = 0; i < 20000; i++)
+    {
+        vi key = {i, i % 11};
+        REQUIRE(table.tryClaim(key, i % 5, pinned, 0, 0) != nullptr);
+    }
+    REQUIRE(table.evictions > 0);
+    REQUIRE(table.size() + table.evictions == 20001);
+    REQUIRE(table.size() < 2000);
+    // Entries still referred to outside the table stay valid after eviction
+    REQUIRE(pinned->hasKey(pinnedKey));
+    // A forgotten state can be claimed again
+    vi again = {0, 0};
+    if (table.find(again) == nullptr)
+        REQUIRE(table.tryClaim(again, 0, nullptr, 0, 0) != nullptr);
+    pinned = nullptr;
+    table.clear();
+    REQUIRE(table.evictions == 0);
+}
+
+TEST_CASE("pathArena reuses the memory of released nodes", "[transpositionTable]")
+{
+    pathArena arena;
+    vi key = {1, 2, 3};
+    assemblyPath *parentNode = nullptr, *childNode = nullptr;
+    {
+        pathPtr parent(arena.create(key, 0, nullptr, 0, 0));
+        pathPtr child(arena.create(key, 1, parent, 0, 0));
+        REQUIRE(parent->refs == 2);
+        REQUIRE(child->parent == parent);
+        parentNode = parent.get();
+        childNode = child.get();
+    }
+    // Releasing the child released the parent, so both blocks are free again
+    pathPtr a(arena.create(key, 0, nullptr, 0, 0)), b(arena.create(key, 0, nullptr, 0, 0));
+    REQUIRE(((a.get() == parentNode && b.get() == childNode) || (a.get() == childNode && b.get() == parentNode)));
+    REQUIRE(arena.slabs.size() == 1);
+    REQUIRE(a->hasKey(key));
+    a = b = nullptr;
+    arena.reset();
+    REQUIRE(arena.slabs.empty());
+}
+
+TEST_CASE("stateKey sorts all but the first index and compares inline and spilled keys alike", "[transpositionTable]")
+{
+    std::vector<int> canon = {7, 3, 9, 1};
+    uint64_t idSum = 0;
+    for (int id : canon)
+        idSum += stateKey::idKey(id);
+    stateKey key(canon.size(), canon.data(), sizeof(int), idSum);
+    vi expected = {7, 1, 3, 9};
+    REQUIRE(key == stateKey(expected));
+    REQUIRE(key.fingerprint() == stateKey(expected).fingerprint());
+    REQUIRE(key != stateKey(vi{1, 3, 7, 9}));
+    // The fingerprint does not depend on the order of the sorted indices, but does on which one comes first
+    REQUIRE(stateKey(vi{7, 9, 3, 1}).fingerprint() == key.fingerprint());
+    REQUIRE(stateKey(vi{1, 3, 7, 9}).fingerprint() != key.fingerprint());
+    REQUIRE(stateKey(vi{7, 1, 1, 3}).fingerprint() != stateKey(vi{7, 3}).fingerprint());
+
+    // Longer than the inline buffer
+    vi longIds;
+    for (int i = 0; i < int(stateKey::INLINE_IDS) + 5; i++)
+        longIds.push_back(i);
+    stateKey spilled(longIds), copy = spilled;
+    REQUIRE(copy == spilled);
+    REQUIRE(copy.size() == longIds.size());
+    REQUIRE(copy[stateKey::INLINE_IDS + 4] == int(stateKey::INLINE_IDS) + 4);
+
+    transpositionTable table;
+    pathPtr ap = table.tryClaim(spilled, 1, nullptr, 0, 0);
+    REQUIRE(ap != nullptr);
+    REQUIRE(ap->hasKey(copy));
+    REQUIRE(table.find(copy) == ap);
+
+    // A key that has only its fingerprint yet is built when it meets a slot with the same fingerprint
+    struct fragment
+    {
+        int bonds, canon;
+    } frags[] = {{3, 7}, {1, 9}, {2, 3}, {1, 1}};
+    stateKey pending(4, &frags[0].canon, sizeof(fragment), idSum);
+    REQUIRE(table.tryClaim(key, 2, nullptr, 0, 0) != nullptr);
+    REQUIRE(table.tryClaim(pending, 2, nullptr, 0, 0) == nullptr);
+    REQUIRE(pending[1] == 1);
+    REQUIRE(pending == stateKey(expected));
+    ap = nullptr;
+    table.clear();
+}
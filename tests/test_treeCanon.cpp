@@ -0,0 +1,55 @@
+#include <catch2/catch_all.hpp>
+#include <bitset>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "molfileParser.h"
+#include "molGraph.h"
+#include "test_utils.h" // for CoutSilencer, randomSubgraphs
+#include "treeCanon.h"
+#include "vf2.h"
+
+extern std::filesystem::path g_repo_root;
+
+TEST_CASE("treeCanonKey agrees with vf2 on random trees of a macrolide", "[treeCanon]")
+{
+    std::ifstream molFile(g_repo_root / "tests/speed/molfiles/erythromycin.mol");
+    REQUIRE(molFile.is_open());
+    molGraph mg;
+    {
+        CoutSilencer silence;
+        molfileParser(molFile, mg);
+    }
+    std::vector<edgeL> edges = mg.writeEdgeList();
+    std::mt19937 rng(2024);
+    std::vector<std::bitset<512>> masks;
+    std::vector<labelledGraph> trees;
+    std::vector<uint32_t> keys;
+    // Odd sizes give trees with one centroid and even sizes some with two
+    for (const std::bitset<512> &mask : randomSubgraphs(mg.mg.size(), edges, {3, 4, 5, 6, 7, 8}, 60, rng))
+    {
+        labelledGraph g = toLabelledGraph<512>(mg, edges, mask);
+        if (g.nbr.size() != 2 * size_t(g.n - 1))
+            continue;
+        masks.push_back(mask);
+        trees.push_back(g);
+        keys.push_back(treeCanonKey(g));
+    }
+    REQUIRE(trees.size() > 200);
+
+    int isomorphic = 0;
+    for (size_t i = 0; i < trees.size(); i++)
+    {
+        for (size_t j = i + 1; j < trees.size(); j++)
+        {
+            if (trees[i].n != trees[j].n)
+                continue;
+            bool iso = vf2GraphIso(trees[i], trees[j]);
+            isomorphic += iso && masks[i] != masks[j];
+            REQUIRE((keys[i] == keys[j]) == iso);
+        }
+    }
+    REQUIRE(isomorphic > 0);
+}
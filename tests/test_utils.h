@@ -1,8 +1,12 @@
 #pragma once
 
+#include <bitset>
 #include <iostream>
 #include <fstream>
+#include <random>
 #include <streambuf>
+#include <vector>
+#include "globalPrimitives.h"
 
 #ifdef _WIN32
 #define DEV_NULL "NUL"
@@ -27,3 +31,35 @@ struct CoutSilencer
         std::cout.rdbuf(old_buf);
     }
 };
+
+// Connected subgraphs of a molecule, each grown from a random bond by adding random bonds next to it
+inline std::vector<std::bitset<512>> randomSubgraphs(size_t atoms, const std::vector<edgeL> &edges,
+                                                     const std::vector<size_t> &sizes, int perSize, std::mt19937 &rng)
+{
+    std::vector<std::bitset<512>> masks;
+    std::vector<bool> touched(atoms);
+    for (size_t size : sizes)
+    {
+        for (int k = 0; k < perSize; k++)
+        {
+            std::bitset<512> mask;
+            mask.set(rng() % edges.size());
+            while (mask.count() < size)
+            {
+                std::vector<size_t> frontier;
+                std::fill(touched.begin(), touched.end(), false);
+                for (size_t i = 0; i < edges.size(); i++)
+                    if (mask[i])
+                        touched[edges[i].a] = touched[edges[i].b] = true;
+                for (size_t i = 0; i < edges.size(); i++)
+                    if (!mask[i] && (touched[edges[i].a] || touched[edges[i].b]))
+                        frontier.push_back(i);
+                if (frontier.empty())
+                    break;
+                mask.set(frontier[rng() % frontier.size()]);
+            }
+            masks.push_back(mask);
+        }
+    }
+    return masks;
+}
@@ -0,0 +1,93 @@
+#include <catch2/catch_all.hpp>
+#include <bitset>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "graphCanon.h"
+#include "molfileParser.h"
+#include "molGraph.h"
+#include "test_utils.h" // for CoutSilencer, randomSubgraphs
+#include "vf2.h"
+
+extern std::filesystem::path g_repo_root;
+
+static molGraph speedMolecule(const std::string &name)
+{
+    std::ifstream molFile(g_repo_root / "tests/speed/molfiles" / (name + ".mol"));
+    REQUIRE(molFile.is_open());
+    molGraph mg;
+    CoutSilencer silence;
+    molfileParser(molFile, mg);
+    return mg;
+}
+
+TEST_CASE("native vf2 agrees with the boost matcher", "[vf2]")
+{
+    for (const std::string name : {"erythromycin", "cefiderocol"})
+    {
+        molGraph mg = speedMolecule(name);
+        std::vector<edgeL> edges = mg.writeEdgeList();
+        std::mt19937 rng(777);
+        std::vector<std::bitset<512>> masks = randomSubgraphs(mg.mg.size(), edges, {5, 9, 14}, 30, rng);
+        int isomorphic = 0;
+        for (size_t i = 0; i < masks.size(); i++)
+        {
+            labelledGraph a = toLabelledGraph<512>(mg, edges, masks[i]);
+            for (size_t j = i; j < masks.size(); j++)
+            {
+                if (masks[i].count() != masks[j].count())
+                    continue;
+                labelledGraph b = toLabelledGraph<512>(mg, edges, masks[j]);
+                molGraphBoost ba = edgelistToBoost<512>(mg, edges, masks[i]), bb = edgelistToBoost<512>(mg, edges, masks[j]);
+                bool iso = vf2GraphIso(ba, bb);
+                isomorphic += iso;
+                REQUIRE(vf2GraphIso(a, b) == iso);
+            }
+        }
+        REQUIRE(isomorphic > int(masks.size()));
+    }
+}
+
+TEST_CASE("vf2 microbenchmark on isomorphic fragment pairs", "[.][benchmark][vf2]")
+{
+    for (const std::string name : {"erythromycin", "cefiderocol", "clarithromycin"})
+    {
+        molGraph mg = speedMolecule(name);
+        std::vector<edgeL> edges = mg.writeEdgeList();
+        std::mt19937 rng(1);
+        std::vector<std::bitset<512>> masks = randomSubgraphs(mg.mg.size(), edges, {8, 12, 16, 20}, 300, rng);
+        // Pairs of distinct isomorphic masks, the ones a hash collision has to confirm
+        std::vector<std::pair<size_t, size_t>> pairs;
+        std::vector<std::string> certificates;
+        for (const std::bitset<512> &m : masks)
+            certificates.push_back(canonicalCertificate(toLabelledGraph<512>(mg, edges, m)));
+        for (size_t i = 0; i < masks.size() && pairs.size() < 2000; i++)
+            for (size_t j = i + 1; j < masks.size() && pairs.size() < 2000; j++)
+                if (masks[i] != masks[j] && certificates[i] == certificates[j])
+                    pairs.emplace_back(i, j);
+        REQUIRE(!pairs.empty());
+
+        BENCHMARK(name + " boost")
+        {
+            int found = 0;
+            for (const std::pair<size_t, size_t> &p : pairs)
+            {
+                molGraphBoost a = edgelistToBoost<512>(mg, edges, masks[p.first]),
+                              b = edgelistToBoost<512>(mg, edges, masks[p.second]);
+                found += vf2GraphIso(a, b);
+            }
+            return found;
+        };
+        BENCHMARK(name + " native")
+        {
+            int found = 0;
+            for (const std::pair<size_t, size_t> &p : pairs)
+                found += vf2GraphIso(toLabelledGraph<512>(mg, edges, masks[p.first]),
+                                     toLabelledGraph<512>(mg, edges, masks[p.second]));
+            return found;
+        };
+    }
+}